@@ -0,0 +1,106 @@
+#include "Arena.h"
+#include <new>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+using namespace std;
+
+enum ChunkKind { CHUNK_HEAP = 0, CHUNK_MAP = 1, CHUNK_HUGE = 2 };
+
+static const size_t HUGE_PAGE = 2 * 1024 * 1024;
+
+static size_t roundUp(size_t v, size_t a) { return (v + a - 1) / a * a; }
+
+Arena::Arena(const ArenaOptions& opt) : _opt(opt) {
+    if (_opt.chunkSize < 4096) _opt.chunkSize = 4096;
+}
+
+Arena::~Arena() {
+    for (const Chunk& c : _chunks) unmapChunk(c);
+}
+
+bool Arena::mapChunk(size_t minBytes, Chunk& c) {
+    size_t size = minBytes > _opt.chunkSize ? minBytes : _opt.chunkSize;
+    if (_opt.hugePages) {
+        size = roundUp(size, HUGE_PAGE);
+#ifdef _WIN32
+        SIZE_T large = GetLargePageMinimum();
+        if (large) {
+            SIZE_T sz = roundUp(size, large);
+            void* p = VirtualAlloc(NULL, sz, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+            if (p) { c = {static_cast<char*>(p), sz, CHUNK_HUGE}; return true; }
+        }
+        void* p = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        if (p) { c = {static_cast<char*>(p), size, CHUNK_MAP}; return true; }
+#else
+        void* p = MAP_FAILED;
+#ifdef MAP_HUGETLB
+        p = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) { c = {static_cast<char*>(p), size, CHUNK_HUGE}; return true; }
+#endif
+        // No reserved huge pages: ask for transparent huge pages instead
+        p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p != MAP_FAILED) {
+#ifdef MADV_HUGEPAGE
+            madvise(p, size, MADV_HUGEPAGE);
+#endif
+            c = {static_cast<char*>(p), size, CHUNK_MAP};
+            return true;
+        }
+#endif
+        return false;
+    }
+    char* p = static_cast<char*>(malloc(size));
+    if (!p) return false;
+    c = {p, size, CHUNK_HEAP};
+    return true;
+}
+
+void Arena::unmapChunk(const Chunk& c) {
+    if (c.kind == CHUNK_HEAP) { free(c.base); return; }
+#ifdef _WIN32
+    VirtualFree(c.base, 0, MEM_RELEASE);
+#else
+    munmap(c.base, c.size);
+#endif
+}
+
+void* Arena::grow(size_t n, size_t align) {
+    const size_t need = n + align;
+    // Rewound batches reuse the chunks mapped earlier, in order
+    size_t next = _ptr ? _cur + 1 : 0;
+    while (next < _chunks.size() && _chunks[next].size < need) next++;
+
+    if (next >= _chunks.size()) {
+        Chunk c;
+        if (!mapChunk(need, c)) throw bad_alloc();
+        _stats.chunks++;
+        _stats.reserved += c.size;
+        if (c.kind == CHUNK_HUGE) _stats.hugeChunks++;
+        _chunks.push_back(c);
+        next = _chunks.size() - 1;
+    }
+
+    // Bytes skipped at the end of the previous chunk count as used
+    if (_ptr) _used += _end - _ptr;
+    _cur = next;
+    _ptr = _chunks[_cur].base;
+    _end = _chunks[_cur].base + _chunks[_cur].size;
+    return alloc(n, align);
+}
+
+void Arena::reset() {
+    if (_used > _stats.peakBatch) _stats.peakBatch = _used;
+    _stats.resets++;
+    _used = 0;
+    _cur = 0;
+    if (_chunks.empty()) return;
+    _ptr = _chunks[0].base;
+    _end = _chunks[0].base + _chunks[0].size;
+}
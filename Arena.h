@@ -0,0 +1,112 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+// Monotonic arena for per-batch string data.
+//
+// While one input chunk is processed, parsers and formatters carve their
+// temporaries (Big5 -> UTF-8 names, CSV lines) out of the arena instead of
+// the heap. When the chunk is done, main calls reset(): the bump pointer
+// rewinds to the first chunk and everything is released in O(1). Chunks
+// are kept for the next batch, so a steady stream does no allocation at
+// all after warm-up. Nothing is destroyed on reset, so only trivially
+// destructible objects may live here.
+//
+// Chunks can be backed by huge pages: Linux MAP_HUGETLB, falling back to
+// transparent huge pages (madvise); Windows MEM_LARGE_PAGES when the
+// process holds SeLockMemoryPrivilege.
+
+struct ArenaOptions {
+    size_t chunkSize = 1024 * 1024;   // bytes per chunk (larger requests get their own)
+    bool   hugePages = false;
+};
+
+struct ArenaStats {
+    uint64_t allocs{};       // allocation calls
+    uint64_t bytes{};        // bytes handed out (including alignment)
+    uint64_t resets{};       // batches released
+    uint64_t chunks{};       // chunks mapped
+    uint64_t reserved{};     // bytes mapped
+    uint64_t hugeChunks{};   // chunks backed by explicit huge / large pages
+    uint64_t peakBatch{};    // most bytes used by one batch
+};
+
+class Arena {
+public:
+    explicit Arena(const ArenaOptions& opt = ArenaOptions());
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* alloc(size_t n, size_t align = alignof(std::max_align_t)) {
+        uintptr_t p = ((uintptr_t)_ptr + (align - 1)) & ~(uintptr_t)(align - 1);
+        if (_ptr && p + n <= (uintptr_t)_end) {
+            _stats.allocs++;
+            _stats.bytes += (p + n) - (uintptr_t)_ptr;
+            _used += (p + n) - (uintptr_t)_ptr;
+            _ptr = (char*)(p + n);
+            return (void*)p;
+        }
+        return grow(n, align);
+    }
+
+    char* allocChars(size_t n) { return static_cast<char*>(alloc(n, 1)); }
+
+    template <class T>
+    T* allocArray(size_t n) {
+        static_assert(std::is_trivially_destructible<T>::value, "reset() never runs destructors");
+        return static_cast<T*>(alloc(n * sizeof(T), alignof(T)));
+    }
+
+    std::string_view copy(const char* p, size_t n) {
+        char* d = allocChars(n);
+        memcpy(d, p, n);
+        return std::string_view(d, n);
+    }
+
+    // Formatters: reserve an upper bound, write, then give back the tail.
+    // Only valid while no other allocation happened in between.
+    char* reserve(size_t maxBytes) { return allocChars(maxBytes); }
+    void  shrinkLast(char* p, size_t maxBytes, size_t used) {
+        if (p + maxBytes == _ptr) {
+            _ptr = p + used;
+            _stats.bytes -= maxBytes - used;
+            _used -= maxBytes - used;
+        }
+    }
+
+    // Release the current batch (O(1))
+    void reset();
+
+    size_t used() const { return _used; }
+    const ArenaStats& stats() const { return _stats; }
+    const ArenaOptions& options() const { return _opt; }
+
+private:
+    struct Chunk {
+        char*  base;
+        size_t size;
+        int    kind;    // how it was mapped, see Arena.cpp
+    };
+
+    void* grow(size_t n, size_t align);
+    bool  mapChunk(size_t minBytes, Chunk& c);
+    void  unmapChunk(const Chunk& c);
+
+    ArenaOptions       _opt;
+    ArenaStats         _stats;
+    std::vector<Chunk> _chunks;
+    size_t _cur  = 0;           // chunk being filled
+    char*  _ptr  = nullptr;
+    char*  _end  = nullptr;
+    size_t _used = 0;           // bytes in this batch
+};
+
+#endif // ARENA_H
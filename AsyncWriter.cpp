@@ -0,0 +1,514 @@
+#include "AsyncWriter.h"
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <fcntl.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <malloc.h>
+#else
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+#ifdef TSE_WITH_LIBURING
+#include <liburing.h>
+#include <unordered_set>
+#include <cerrno>
+#endif
+
+using namespace std;
+
+static uint64_t nowNs() {
+    return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ---- small platform layer -------------------------------------------------
+
+static int openOut(const string& path, bool direct, bool truncate = true) {
+#ifdef _WIN32
+    (void)direct;
+    return _open(path.c_str(), _O_WRONLY | _O_CREAT | (truncate ? _O_TRUNC : 0) | _O_BINARY, 0644);
+#else
+    int flags = O_WRONLY | O_CREAT | (truncate ? O_TRUNC : 0);
+#ifdef O_DIRECT
+    if (direct) flags |= O_DIRECT;
+#else
+    (void)direct;
+#endif
+    return ::open(path.c_str(), flags, 0644);
+#endif
+}
+
+// Write the whole range at offset. Returns bytes written or -1.
+static long long writeAt(int fd, const char* p, size_t n, uint64_t off) {
+    size_t done = 0;
+    while (done < n) {
+#ifdef _WIN32
+        if (_lseeki64(fd, (long long)(off + done), SEEK_SET) < 0) return -1;
+        int w = _write(fd, p + done, (unsigned)(n - done));
+#else
+        ssize_t w = ::pwrite(fd, p + done, n - done, (off_t)(off + done));
+#endif
+        if (w <= 0) return -1;
+        done += (size_t)w;
+    }
+    return (long long)done;
+}
+
+static void syncFd(int fd) {
+#ifdef _WIN32
+    _commit(fd);
+#else
+    ::fsync(fd);
+#endif
+}
+
+static void truncateFd(int fd, uint64_t size) {
+#ifdef _WIN32
+    _chsize_s(fd, (long long)size);
+#else
+    if (::ftruncate(fd, (off_t)size) != 0) {
+        cerr << "[ERROR] ftruncate failed\n";
+    }
+#endif
+}
+
+static void closeFd(int fd) {
+#ifdef _WIN32
+    _close(fd);
+#else
+    ::close(fd);
+#endif
+}
+
+static char* allocAligned(size_t n) {
+#ifdef _WIN32
+    return static_cast<char*>(_aligned_malloc(n, WriteRing::ALIGN));
+#else
+    void* p = nullptr;
+    if (posix_memalign(&p, WriteRing::ALIGN, n) != 0) return nullptr;
+    return static_cast<char*>(p);
+#endif
+}
+
+static void freeAligned(char* p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+// ---- WriteRing --------------------------------------------------------------
+
+#ifdef TSE_WITH_LIBURING
+struct WriteRing::Uring {
+    struct io_uring ring;
+    std::mutex      sqMu;  // sinks may submit from different threads
+    std::unordered_set<Request*> inflight;  // guarded by sqMu
+    bool            failed = false;         // completion queue unusable
+};
+#else
+struct WriteRing::Uring {};
+#endif
+
+WriteRing::WriteRing() {}
+
+WriteRing::~WriteRing() {
+    stop();
+}
+
+bool WriteRing::start(unsigned queueDepth) {
+    if (_running) return true;
+
+#ifdef TSE_WITH_LIBURING
+    _uring.reset(new Uring());
+    if (io_uring_queue_init(queueDepth, &_uring->ring, 0) == 0) {
+        _backend = "io_uring";
+        _running = true;
+        _thread = thread(&WriteRing::completionLoop, this);
+        return true;
+    }
+    cerr << "[WARN] io_uring unavailable, falling back to pwrite thread\n";
+    _uring.reset();
+#else
+    (void)queueDepth;
+#endif
+
+    _backend = "pwrite-thread";
+    _quit = false;
+    _running = true;
+    _thread = thread(&WriteRing::workerLoop, this);
+    return true;
+}
+
+void WriteRing::stop() {
+    if (!_running) return;
+
+#ifdef TSE_WITH_LIBURING
+    if (_uring) {
+        // A NOP with null user_data tells the completion thread to exit
+        {
+            lock_guard<mutex> lk(_uring->sqMu);
+            struct io_uring_sqe* sqe = io_uring_get_sqe(&_uring->ring);
+            while (!sqe) {
+                io_uring_submit(&_uring->ring);
+                sqe = io_uring_get_sqe(&_uring->ring);
+            }
+            io_uring_prep_nop(sqe);
+            io_uring_sqe_set_data(sqe, nullptr);
+            io_uring_submit(&_uring->ring);
+        }
+        if (_thread.joinable()) _thread.join();
+        io_uring_queue_exit(&_uring->ring);
+        _uring.reset();
+        _running = false;
+        return;
+    }
+#endif
+
+    {
+        lock_guard<mutex> lk(_qMu);
+        _quit = true;
+    }
+    _qCv.notify_all();
+    if (_thread.joinable()) _thread.join();
+    _running = false;
+}
+
+unique_ptr<AsyncSink> WriteRing::openSink(const string& path, const AsyncWriterOptions& opt) {
+    if (!_running && !start()) return nullptr;
+
+    int fd = openOut(path, opt.directIO);
+    if (fd < 0 && opt.directIO) {
+        cerr << "[WARN] O_DIRECT open failed for " << path << ", using buffered I/O\n";
+        AsyncWriterOptions o = opt;
+        o.directIO = false;
+        fd = openOut(path, false);
+        if (fd < 0) return nullptr;
+        unique_ptr<AsyncSink> sink(new AsyncSink(*this, fd, path, o));
+        if (sink->_fd < 0) return nullptr;
+        return sink;
+    }
+    if (fd < 0) return nullptr;
+    unique_ptr<AsyncSink> sink(new AsyncSink(*this, fd, path, opt));
+    if (sink->_fd < 0) return nullptr;
+    return sink;
+}
+
+unique_ptr<AsyncSink> WriteRing::resumeSink(const string& path, const AsyncWriterOptions& opt,
+                                           uint64_t size) {
+    if (!_running && !start()) return nullptr;
+
+    // Bytes of the last partial block: O_DIRECT rewrites that block whole
+    string tail;
+    {
+        ifstream fin(path, ios::binary | ios::ate);
+        if (!fin || (uint64_t)fin.tellg() < size) return nullptr;
+        uint64_t base = opt.directIO ? size / ALIGN * ALIGN : size;
+        tail.resize((size_t)(size - base));
+        fin.seekg((streamoff)base);
+        fin.read(&tail[0], (streamsize)tail.size());
+        if ((size_t)fin.gcount() != tail.size()) return nullptr;
+    }
+
+    AsyncWriterOptions o = opt;
+    int fd = openOut(path, o.directIO, false);
+    if (fd < 0 && o.directIO) {
+        cerr << "[WARN] O_DIRECT open failed for " << path << ", using buffered I/O\n";
+        o.directIO = false;
+        tail.clear();
+        fd = openOut(path, false, false);
+    }
+    if (fd < 0) return nullptr;
+    truncateFd(fd, size);
+
+    unique_ptr<AsyncSink> sink(new AsyncSink(*this, fd, path, o));
+    if (sink->_fd < 0) return nullptr;
+    sink->continueAt(size, tail);
+    return sink;
+}
+
+void WriteRing::submit(const Request& req) {
+#ifdef TSE_WITH_LIBURING
+    if (_uring) {
+        Request* heapReq = new Request(req);
+        unique_lock<mutex> lk(_uring->sqMu);
+        if (_uring->failed) {
+            lk.unlock();
+            delete heapReq;
+            onComplete(req, -1);
+            return;
+        }
+        _uring->inflight.insert(heapReq);
+        struct io_uring_sqe* sqe = io_uring_get_sqe(&_uring->ring);
+        while (!sqe) {
+            io_uring_submit(&_uring->ring);
+            sqe = io_uring_get_sqe(&_uring->ring);
+        }
+        io_uring_prep_write(sqe, req.fd, req.data, (unsigned)req.len, req.off);
+        io_uring_sqe_set_data(sqe, heapReq);
+        io_uring_submit(&_uring->ring);
+        return;
+    }
+#endif
+    {
+        lock_guard<mutex> lk(_qMu);
+        _queue.push_back(req);
+    }
+    _qCv.notify_one();
+}
+
+void WriteRing::onComplete(const Request& req, long long res) {
+    req.sink->completed(req.bufIdx, res == (long long)req.len);
+}
+
+void WriteRing::workerLoop() {
+    while (true) {
+        Request req;
+        {
+            unique_lock<mutex> lk(_qMu);
+            _qCv.wait(lk, [this] { return _quit || !_queue.empty(); });
+            if (_queue.empty()) return; // quit and drained
+            req = _queue.front();
+            _queue.pop_front();
+        }
+        onComplete(req, writeAt(req.fd, req.data, req.len, req.off));
+    }
+}
+
+void WriteRing::completionLoop() {
+#ifdef TSE_WITH_LIBURING
+    while (true) {
+        struct io_uring_cqe* cqe = nullptr;
+        int rc = io_uring_wait_cqe(&_uring->ring, &cqe);
+        if (rc == -EINTR) continue;
+        if (rc < 0) {
+            // No completion will arrive: fail what is in flight and every
+            // later submission so the sinks' close() does not wait forever
+            cerr << "[ERROR] io_uring wait failed: " << strerror(-rc) << "\n";
+            unordered_set<Request*> lost;
+            {
+                lock_guard<mutex> lk(_uring->sqMu);
+                _uring->failed = true;
+                lost.swap(_uring->inflight);
+            }
+            for (Request* r : lost) {
+                onComplete(*r, -1);
+                delete r;
+            }
+            return;
+        }
+
+        Request* req = static_cast<Request*>(io_uring_cqe_get_data(cqe));
+        int res = cqe->res;
+        io_uring_cqe_seen(&_uring->ring, cqe);
+        if (!req) return; // shutdown NOP
+        {
+            lock_guard<mutex> lk(_uring->sqMu);
+            _uring->inflight.erase(req);
+        }
+
+        if (res > 0 && (size_t)res < req->len) {
+            // Short write: push the remainder synchronously, we are off the hot thread
+            long long rest = writeAt(req->fd, req->data + res, req->len - res, req->off + res);
+            res = (rest < 0) ? -1 : (int)req->len;
+        }
+        onComplete(*req, res);
+        delete req;
+    }
+#endif
+}
+
+// ---- AsyncSink --------------------------------------------------------------
+
+AsyncSink::AsyncSink(WriteRing& ring, int fd, const string& path, const AsyncWriterOptions& opt)
+    : _ring(ring), _fd(fd), _path(path), _opt(opt)
+{
+    if (_opt.bufferCount < 2) _opt.bufferCount = 2;
+    _opt.bufferSize = (_opt.bufferSize + WriteRing::ALIGN - 1) / WriteRing::ALIGN * WriteRing::ALIGN;
+    if (_opt.bufferSize == 0) _opt.bufferSize = WriteRing::ALIGN;
+
+    _bufs.resize(_opt.bufferCount);
+    for (auto& b : _bufs) {
+        b.data = allocAligned(_opt.bufferSize);
+        if (!b.data) {
+            // Unusable sink: the factory sees _fd < 0 and drops it
+            cerr << "[ERROR] cannot allocate " << _opt.bufferCount << " x " << _opt.bufferSize
+                 << " byte output buffers for " << _path << "\n";
+            closeFd(_fd);
+            _fd = -1;
+            _closed = true;
+            return;
+        }
+    }
+    _bufs[0].state = FILLING;
+}
+
+AsyncSink::~AsyncSink() {
+    close();
+    for (auto& b : _bufs) freeAligned(b.data);
+}
+
+void AsyncSink::write(const char* p, size_t n) {
+    _m.bytesWritten += n;
+    while (n > 0) {
+        Buffer& b = _bufs[_cur];
+        size_t room = _opt.bufferSize - b.used;
+        size_t take = (n < room) ? n : room;
+        memcpy(b.data + b.used, p, take);
+        b.used += take;
+        p += take;
+        n -= take;
+        if (b.used == _opt.bufferSize) {
+            submitCurrent(false);
+            acquireNext();
+        }
+    }
+}
+
+void AsyncSink::put(char c) {
+    Buffer& b = _bufs[_cur];
+    b.data[b.used++] = c;
+    _m.bytesWritten++;
+    if (b.used == _opt.bufferSize) {
+        submitCurrent(false);
+        acquireNext();
+    }
+}
+
+void AsyncSink::continueAt(uint64_t size, const string& tail) {
+    _fileOff = _logicalSize = size - tail.size();
+    memcpy(_bufs[_cur].data, tail.data(), tail.size());
+    _bufs[_cur].used = tail.size();
+    _m.bytesWritten = size;
+}
+
+uint64_t AsyncSink::sync() {
+    if (_closed) return _m.bytesWritten;
+
+    Buffer& b = _bufs[_cur];
+    const size_t len = b.used;
+    size_t keep = 0;
+    char tail[WriteRing::ALIGN];
+    if (len > 0) {
+        size_t wlen = len;
+        if (_opt.directIO) {
+            keep = len % WriteRing::ALIGN;
+            wlen = (len + WriteRing::ALIGN - 1) / WriteRing::ALIGN * WriteRing::ALIGN;
+            memcpy(tail, b.data + len - keep, keep);
+            memset(b.data + len, 0, wlen - len);
+        }
+        {
+            lock_guard<mutex> lk(_mu);
+            b.state = INFLIGHT;
+            _inflight++;
+        }
+        _m.buffersSubmitted++;
+        _ring.submit(WriteRing::Request{this, _cur, _fd, b.data, wlen, _fileOff});
+    }
+    {
+        unique_lock<mutex> lk(_mu);
+        _cv.wait(lk, [this] { return _inflight == 0; });
+        b.state = FILLING;
+    }
+    // The aligned part is final; the tail is written again later at the same offset
+    _fileOff     += len - keep;
+    _logicalSize += len - keep;
+    memcpy(b.data, tail, keep);
+    b.used = keep;
+
+    syncFd(_fd);
+    return _m.bytesWritten;
+}
+
+void AsyncSink::flush() {
+    if (_closed || _opt.directIO || _bufs[_cur].used == 0) return;
+    submitCurrent(false);
+    acquireNext();
+}
+
+void AsyncSink::submitCurrent(bool final) {
+    Buffer& b = _bufs[_cur];
+    if (b.used == 0) return;
+
+    size_t len = b.used;
+    _logicalSize += b.used;
+    if (final && _opt.directIO) {
+        // O_DIRECT needs aligned length: pad with zeros, truncate in close()
+        size_t padded = (len + WriteRing::ALIGN - 1) / WriteRing::ALIGN * WriteRing::ALIGN;
+        memset(b.data + len, 0, padded - len);
+        len = padded;
+    }
+
+    {
+        lock_guard<mutex> lk(_mu);
+        b.state = INFLIGHT;
+        _inflight++;
+    }
+    _m.buffersSubmitted++;
+
+    WriteRing::Request req{this, _cur, _fd, b.data, len, _fileOff};
+    _fileOff += len;
+    _ring.submit(req);
+}
+
+void AsyncSink::acquireNext() {
+    _cur = (_cur + 1) % (int)_bufs.size();
+    Buffer& b = _bufs[_cur];
+
+    unique_lock<mutex> lk(_mu);
+    if (b.state == INFLIGHT) {
+        uint64_t t0 = nowNs();
+        _m.bufferStalls++;
+        _cv.wait(lk, [&b] { return b.state != INFLIGHT; });
+        _m.stallNs += nowNs() - t0;
+    }
+    b.state = FILLING;
+    b.used = 0;
+}
+
+void AsyncSink::completed(int bufIdx, bool ok) {
+    {
+        lock_guard<mutex> lk(_mu);
+        _bufs[bufIdx].state = FREE;
+        _bufs[bufIdx].used = 0;
+        _inflight--;
+        if (!ok) _m.ioError = true;
+    }
+    _cv.notify_all();
+}
+
+bool AsyncSink::close() {
+    if (_closed) return !_m.ioError;
+    _closed = true;
+
+    uint64_t t0 = nowNs();
+    submitCurrent(true);
+    {
+        unique_lock<mutex> lk(_mu);
+        _cv.wait(lk, [this] { return _inflight == 0; });
+    }
+    if (_opt.directIO && _fileOff != _logicalSize) {
+        truncateFd(_fd, _logicalSize);
+    }
+    _m.flushNs = nowNs() - t0;
+
+    if (_opt.fsyncOnClose) {
+        uint64_t t1 = nowNs();
+        syncFd(_fd);
+        _m.fsyncNs = nowNs() - t1;
+    }
+    closeFd(_fd);
+    _fd = -1;
+
+    if (_m.ioError) {
+        cerr << "[ERROR] write to " << _path << " failed\n";
+    }
+    return !_m.ioError;
+}
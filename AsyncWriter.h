@@ -0,0 +1,169 @@
+#ifndef ASYNC_WRITER_H
+#define ASYNC_WRITER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// Asynchronous file output shared by every CSV / binary sink.
+//
+// Each AsyncSink owns N large aligned buffers. The parser thread fills one
+// buffer while previously filled buffers are being written by the shared
+// WriteRing. Backend is io_uring (build with TSE_WITH_LIBURING and link
+// -luring) or, otherwise, a single writer thread doing pwrite().
+// Completions are reaped on the ring thread, never on the parser thread.
+
+class AsyncSink;
+
+struct AsyncWriterOptions {
+    size_t bufferSize  = 4 * 1024 * 1024; // bytes per buffer (rounded up to ALIGN)
+    int    bufferCount = 2;               // >= 2 : double buffering
+    bool   directIO    = false;           // O_DIRECT (Linux only)
+    bool   fsyncOnClose = true;
+};
+
+// Per-sink counters, reported by main after shutdown
+struct AsyncSinkMetrics {
+    uint64_t bytesWritten{};   // bytes accepted from the parser
+    uint64_t buffersSubmitted{};
+    uint64_t bufferStalls{};   // times the parser waited for a free buffer
+    uint64_t stallNs{};
+    uint64_t flushNs{};        // final drain on close
+    uint64_t fsyncNs{};
+    bool     ioError{false};
+};
+
+class WriteRing {
+public:
+    static const size_t ALIGN = 4096;
+
+    WriteRing();
+    ~WriteRing();
+
+    WriteRing(const WriteRing&) = delete;
+    WriteRing& operator=(const WriteRing&) = delete;
+
+    // Start the backend. Returns false if nothing could be started.
+    bool start(unsigned queueDepth = 64);
+    void stop();
+
+    // "io_uring" or "pwrite-thread"
+    const char* backendName() const { return _backend; }
+
+    // Open a new sink on this ring. Returns nullptr on failure.
+    std::unique_ptr<AsyncSink> openSink(const std::string& path,
+                                        const AsyncWriterOptions& opt);
+
+    // Reopen an existing output, keep its first `size` bytes and continue
+    // after them (checkpoint resume). nullptr if the file is shorter.
+    std::unique_ptr<AsyncSink> resumeSink(const std::string& path,
+                                          const AsyncWriterOptions& opt, uint64_t size);
+
+private:
+    friend class AsyncSink;
+
+    struct Request {
+        AsyncSink* sink;
+        int        bufIdx;
+        int        fd;
+        const char* data;
+        size_t     len;
+        uint64_t   off;
+    };
+
+    void submit(const Request& req);
+    void onComplete(const Request& req, long long res);
+    void workerLoop();       // pwrite-thread backend
+    void completionLoop();   // io_uring backend
+
+    const char* _backend = "none";
+    bool _running = false;
+
+    // pwrite-thread backend
+    std::mutex              _qMu;
+    std::condition_variable _qCv;
+    std::deque<Request>     _queue;
+    bool                    _quit = false;
+    std::thread             _thread;
+
+    // io_uring backend (opaque so the header does not need liburing)
+    struct Uring;
+    std::unique_ptr<Uring>  _uring;
+};
+
+class AsyncSink {
+public:
+    ~AsyncSink();
+
+    AsyncSink(const AsyncSink&) = delete;
+    AsyncSink& operator=(const AsyncSink&) = delete;
+
+    void write(const char* p, size_t n);
+    void write(const std::string& s) { write(s.data(), s.size()); }
+    void put(char c);
+
+    // Submit the partly filled buffer now so the rows reach the file without
+    // waiting for a full buffer (follow mode). No-op with O_DIRECT, which
+    // only allows aligned writes before close().
+    void flush();
+
+    // Write out everything accepted so far, wait for it and fsync; returns
+    // the output size. Blocks the caller (checkpoints only). With O_DIRECT
+    // the unaligned tail is written padded and kept in the buffer, to be
+    // written again at the same offset together with what follows.
+    uint64_t sync();
+
+    // Bytes accepted so far = final file size
+    uint64_t size() const { return _m.bytesWritten; }
+
+    // Submit remaining data, wait for all in-flight writes, fsync, close.
+    // Returns false if any write failed.
+    bool close();
+
+    const std::string& path() const { return _path; }
+    const AsyncSinkMetrics& metrics() const { return _m; }
+
+private:
+    friend class WriteRing;
+
+    enum BufState { FREE, FILLING, INFLIGHT };
+
+    struct Buffer {
+        char*    data = nullptr;
+        size_t   used = 0;
+        BufState state = FREE;
+    };
+
+    AsyncSink(WriteRing& ring, int fd, const std::string& path,
+              const AsyncWriterOptions& opt);
+
+    void continueAt(uint64_t size, const std::string& tail);
+    void submitCurrent(bool final);
+    void acquireNext();
+    void completed(int bufIdx, bool ok);
+
+    WriteRing&         _ring;
+    int                _fd;
+    std::string        _path;
+    AsyncWriterOptions _opt;
+    std::vector<Buffer> _bufs;
+    int                _cur = 0;
+    uint64_t           _fileOff = 0;     // next submission offset (padded for O_DIRECT)
+    uint64_t           _logicalSize = 0; // real output bytes
+    bool               _closed = false;
+
+    std::mutex              _mu;
+    std::condition_variable _cv;
+    int                     _inflight = 0;
+
+    AsyncSinkMetrics   _m;
+};
+
+#endif // ASYNC_WRITER_H
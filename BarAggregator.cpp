@@ -0,0 +1,193 @@
+#include "BarAggregator.h"
+#include "BookLog.h"
+#include "AsyncWriter.h"
+#include "Checkpoint.h"
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+using namespace std;
+
+// ---- CsvBarSink ---------------------------------------------------------------
+
+CsvBarSink::CsvBarSink(AsyncSink* out, bool resumed) : _out(out) {
+    if (resumed) return;
+    _out->write("Interval,Stock ID,Bar Start,Open,High,Low,Close,Volume,VWAP,Trades,Cum Qty\n");
+}
+
+void CsvBarSink::onBar(const Bar& b) {
+    char iv[24];
+    if (b.intervalUs % 60000000 == 0)    snprintf(iv, sizeof(iv), "%lldm", (long long)(b.intervalUs / 60000000));
+    else if (b.intervalUs % 1000000 == 0) snprintf(iv, sizeof(iv), "%llds", (long long)(b.intervalUs / 1000000));
+    else                                  snprintf(iv, sizeof(iv), "%lldms", (long long)(b.intervalUs / 1000));
+
+    string start = usToMatchTime(b.startUs);
+    char line[256];
+    int n = snprintf(line, sizeof(line), "%s,%s,%s,%.4f,%.4f,%.4f,%.4f,%llu,%.4f,%u,%u\n",
+                     iv, b.stockId, start.c_str(), b.open, b.high, b.low, b.close,
+                     (unsigned long long)b.volume, b.vwap, b.trades, b.cumQty);
+    if (n > 0) _out->write(line, (size_t)n);
+    _rows++;
+}
+
+void CsvBarSink::saveState(StateWriter& w) const { w.put(_rows); }
+bool CsvBarSink::loadState(StateReader& r) { return r.get(_rows); }
+
+// ---- BarAggregator --------------------------------------------------------------
+
+BarAggregator::BarAggregator(const vector<int64_t>& intervalsUs, BarSink* sink, size_t maxSymbols)
+    : _intervals(intervalsUs), _sink(sink), _syms(maxSymbols)
+{
+    _lastCum.assign(_syms.capacity(), 0);
+    _seen.assign(_syms.capacity(), 0);
+    _bars.assign(_intervals.size() * _syms.capacity(), Slot{});
+    _clockBucket.assign(_intervals.size(), -1);
+}
+
+int64_t BarAggregator::parseInterval(const string& s) {
+    char* end = nullptr;
+    long long v = strtoll(s.c_str(), &end, 10);
+    if (v <= 0 || !end) return 0;
+    string unit(end);
+    if (unit == "ms") return v * 1000;
+    if (unit == "s")  return v * 1000000;
+    if (unit == "m")  return v * 60000000;
+    if (unit == "h")  return v * 3600000000LL;
+    return 0;
+}
+
+void BarAggregator::emit(size_t iv, int sym) {
+    Slot& s = _bars[iv * _syms.capacity() + sym];
+    Bar b;
+    memset(b.stockId, 0, sizeof(b.stockId));
+    memcpy(b.stockId, &_syms.key(sym), 7);
+    b.intervalUs = _intervals[iv];
+    b.startUs = s.startUs;
+    b.open = s.open;
+    b.high = s.high;
+    b.low = s.low;
+    b.close = s.close;
+    b.volume = s.volume;
+    b.vwap = s.volume ? s.turnover / (double)s.volume : s.close;
+    b.trades = s.trades;
+    b.cumQty = s.cumQty;
+    s.active = false;
+    _barsEmitted++;
+    if (_sink) _sink->onBar(b);
+}
+
+// Close bars of every symbol whose bucket ended before the market clock
+void BarAggregator::advanceClock(int64_t timeUs) {
+    for (size_t iv = 0; iv < _intervals.size(); ++iv) {
+        int64_t bucket = timeUs / _intervals[iv];
+        if (bucket <= _clockBucket[iv]) continue;
+        _clockBucket[iv] = bucket;
+        int64_t start = bucket * _intervals[iv];
+        Slot* row = &_bars[iv * _syms.capacity()];
+        for (size_t i = 0; i < _syms.size(); ++i) {
+            if (row[i].active && row[i].startUs < start) emit(iv, (int)i);
+        }
+    }
+}
+
+void BarAggregator::onMessage(const Tse06Record& r) {
+    int64_t t = matchTimeToUs(r.matchTime);
+    advanceClock(t);
+
+    if (!tse06HasTrade(r.itemBitmap)) return;
+    if (tse06IsDeferred(r.limitBitmap)) { _deferredSkipped++; return; }
+
+    int sym = _syms.slotOf(packId(r.stockId));
+    if (sym < 0) { _overflow++; return; }
+
+    // cumQty must advance; a repeated value is a retransmitted trade
+    if (_seen[sym] && r.cumQty != 0 && r.cumQty <= _lastCum[sym]) { _duplicates++; return; }
+    _seen[sym] = 1;
+    _lastCum[sym] = r.cumQty;
+
+    const double px = r.lastPx;
+    const uint32_t qty = r.lastQty;
+    _tradesUsed++;
+
+    bool late = false;
+    for (size_t iv = 0; iv < _intervals.size(); ++iv) {
+        Slot& s = _bars[iv * _syms.capacity() + sym];
+        int64_t start = t / _intervals[iv] * _intervals[iv];
+        // Behind the market clock: this bucket was closed (and maybe emitted)
+        // already, reopening it would emit the bar twice
+        if (start < _clockBucket[iv] * _intervals[iv]) { late = true; continue; }
+        if (s.active && start > s.startUs) emit(iv, sym);
+
+        if (!s.active) {
+            s.startUs = start;
+            s.open = s.high = s.low = px;
+            s.volume = 0;
+            s.turnover = 0.0;
+            s.trades = 0;
+            s.active = true;
+        }
+        if (px > s.high) s.high = px;
+        if (px < s.low)  s.low = px;
+        s.close = px;
+        s.volume += qty;
+        s.turnover += px * qty;
+        s.trades++;
+        s.cumQty = r.cumQty;
+    }
+    if (late) _late++;
+}
+
+// Only the used slots are saved; the hash table is rebuilt on load
+void BarAggregator::saveState(StateWriter& w) const {
+    w.putVector(_intervals);
+    w.put<uint64_t>(_syms.capacity());
+    w.put<uint64_t>(_syms.size());
+    for (size_t i = 0; i < _syms.size(); ++i) {
+        w.put(_syms.key(i));
+        w.put(_lastCum[i]);
+        w.put(_seen[i]);
+    }
+    for (size_t iv = 0; iv < _intervals.size(); ++iv) {
+        for (size_t i = 0; i < _syms.size(); ++i) w.put(_bars[iv * _syms.capacity() + i]);
+    }
+    w.putVector(_clockBucket);
+    w.put(_tradesUsed);
+    w.put(_deferredSkipped);
+    w.put(_duplicates);
+    w.put(_barsEmitted);
+    w.put(_overflow);
+    w.put(_late);
+}
+
+bool BarAggregator::loadState(StateReader& r) {
+    vector<int64_t> intervals;
+    uint64_t cap = 0, nSyms = 0;
+    if (!r.getVector(intervals) || intervals != _intervals) return false;
+    if (!r.get(cap) || cap != _syms.capacity() || !r.get(nSyms) || nSyms > _syms.capacity()) return false;
+    for (size_t i = 0; i < nSyms && r.ok(); ++i) {
+        uint64_t key = 0;
+        r.get(key);
+        if (key == 0 || _syms.slotOf(key) != (int)i) return false;
+        r.get(_lastCum[i]);
+        r.get(_seen[i]);
+    }
+    for (size_t iv = 0; iv < _intervals.size(); ++iv) {
+        for (size_t i = 0; i < nSyms; ++i) r.get(_bars[iv * _syms.capacity() + i]);
+    }
+    r.getVector(_clockBucket);
+    r.get(_tradesUsed);
+    r.get(_deferredSkipped);
+    r.get(_duplicates);
+    r.get(_barsEmitted);
+    r.get(_overflow);
+    r.get(_late);
+    return r.ok() && _clockBucket.size() == _intervals.size();
+}
+
+void BarAggregator::flush() {
+    for (size_t iv = 0; iv < _intervals.size(); ++iv) {
+        for (size_t i = 0; i < _syms.size(); ++i) {
+            if (_bars[iv * _syms.capacity() + i].active) emit(iv, (int)i);
+        }
+    }
+}
@@ -0,0 +1,113 @@
+#ifndef BAR_AGGREGATOR_H
+#define BAR_AGGREGATOR_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "TseFmt06Parser.h"
+#include "SymbolTable.h"
+
+class AsyncSink;
+class StateWriter;
+class StateReader;
+
+// In-process OHLCV / VWAP bars built from Format 06 trades.
+//
+// Symbols are mapped to dense slots through a SymbolTable keyed by the
+// packed 6-byte stock code; bar state lives in flat arrays
+// [interval][slot] allocated once in the constructor, so onMessage() is
+// O(1) and never allocates. Only messages with the trade bit set and not in
+// deferred matching (暫緩撮合, see tse06IsDeferred) update a bar.
+//
+// A bar is closed when its symbol trades in a later bucket, when the
+// market clock (latest matchTime seen) passes the bucket end, or on flush().
+// A trade whose bucket the clock has already passed is left out of that
+// interval's bars and counted in lateTrades().
+
+struct Bar {
+    char     stockId[8];      // NUL terminated
+    int64_t  intervalUs;
+    int64_t  startUs;         // bucket start, us since midnight
+    double   open, high, low, close;
+    uint64_t volume;
+    double   vwap;
+    uint32_t trades;
+    uint32_t cumQty;          // cumulative volume at the last trade
+};
+
+class BarSink {
+public:
+    virtual ~BarSink() = default;
+    virtual void onBar(const Bar& bar) = 0;
+};
+
+// Writes bars as CSV rows to an AsyncSink
+class CsvBarSink : public BarSink {
+public:
+    // resumed: out already holds the header (checkpoint resume)
+    explicit CsvBarSink(AsyncSink* out, bool resumed = false);
+    void onBar(const Bar& bar) override;
+    uint64_t rows() const { return _rows; }
+
+    void saveState(StateWriter& w) const;
+    bool loadState(StateReader& r);
+private:
+    AsyncSink* _out;
+    uint64_t   _rows = 0;
+};
+
+class BarAggregator {
+public:
+    // intervalsUs: e.g. {1000000, 60000000, 300000000}
+    BarAggregator(const std::vector<int64_t>& intervalsUs, BarSink* sink,
+                  size_t maxSymbols = 65536);
+
+    // Feed one parsed Format 06 message (non-trades only advance the clock)
+    void onMessage(const Tse06Record& r);
+
+    // Close and emit every open bar
+    void flush();
+
+    uint64_t tradesUsed()     const { return _tradesUsed; }
+    uint64_t deferredSkipped() const { return _deferredSkipped; }
+    uint64_t duplicates()     const { return _duplicates; }
+    uint64_t barsEmitted()    const { return _barsEmitted; }
+    uint64_t symbolOverflow() const { return _overflow; }
+    uint64_t lateTrades()     const { return _late; }     // missed a closed bucket
+
+    // Checkpoint: open bars, symbol table, clock and counters. loadState
+    // fails if the intervals or slot count differ from the saved run.
+    void saveState(StateWriter& w) const;
+    bool loadState(StateReader& r);
+
+    // "1s", "1m", "5m", "500ms" -> microseconds (0 if invalid)
+    static int64_t parseInterval(const std::string& s);
+
+private:
+    struct Slot {
+        int64_t  startUs;
+        double   open, high, low, close;
+        uint64_t volume;
+        double   turnover;
+        uint32_t trades;
+        uint32_t cumQty;
+        bool     active;
+    };
+
+    void advanceClock(int64_t timeUs);
+    void emit(size_t iv, int sym);
+
+    std::vector<int64_t>  _intervals;
+    BarSink*              _sink;
+    SymbolTable           _syms;          // packed stock id -> dense slot
+    std::vector<uint32_t> _lastCum;       // dense slot -> last cumQty (duplicate check)
+    std::vector<uint8_t>  _seen;
+    std::vector<Slot>     _bars;          // [interval * capacity + slot]
+    std::vector<int64_t>  _clockBucket;   // per interval: bucket of the market clock
+
+    uint64_t _tradesUsed = 0, _deferredSkipped = 0, _duplicates = 0;
+    uint64_t _barsEmitted = 0, _overflow = 0, _late = 0;
+};
+
+#endif // BAR_AGGREGATOR_H
@@ -0,0 +1,464 @@
+#include "BatchDriver.h"
+#include "WorkStealingPool.h"
+#include "InputSource.h"
+#include "StreamFramer.h"
+#include "TseBaseParser.h"
+#include "TseFmt01Parser.h"
+#include "TseFmt06Parser.h"
+#include "Utils.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <filesystem>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <cstring>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+static const size_t READ_CHUNK = 64 * 1024;   // StreamFramer erases from the front: keep feeds small
+static const size_t SYNC_WINDOW = 256 * 1024;
+static const int    SYNC_CHAIN = 3;       // consecutive valid messages to accept a split point
+static const int    FORMAT_01_LEN = 114;
+static const int    MAX_MSG_LEN = 4096;
+
+// ---- input expansion ----------------------------------------------------------
+
+// '*' and '?' wildcard match on a file name
+static bool wildMatch(const char* pat, const char* s) {
+    if (*pat == '\0') return *s == '\0';
+    if (*pat == '*') return wildMatch(pat + 1, s) || (*s && wildMatch(pat, s + 1));
+    if (*s && (*pat == '?' || *pat == *s)) return wildMatch(pat + 1, s + 1);
+    return false;
+}
+
+static bool endsWith(const string& s, const char* e) {
+    size_t n = strlen(e);
+    return s.size() > n && s.compare(s.size() - n, n, e) == 0;
+}
+
+// Outputs of an earlier run (<stem>_fmt01.csv, _fmt06.csv, .partN), which
+// land next to the inputs with the default --out-dir .
+static bool isBatchOutput(const string& name) {
+    return name.find("_fmt01.csv") != string::npos || name.find("_fmt06.csv") != string::npos;
+}
+
+vector<string> expandInputs(const string& spec) {
+    vector<string> out;
+    error_code ec;
+
+    if (fs::is_directory(spec, ec)) {
+        for (const auto& e : fs::directory_iterator(spec, ec)) {
+            string name = e.path().filename().string();
+            if (!e.is_regular_file(ec) || isBatchOutput(name)) continue;
+            if (endsWith(name, ".bin") || endsWith(name, ".gz") || endsWith(name, ".zst")) {
+                out.push_back(e.path().string());
+            }
+        }
+    } else if (spec.find_first_of("*?") != string::npos) {
+        fs::path p(spec);
+        fs::path dir = p.has_parent_path() ? p.parent_path() : fs::path(".");
+        string pat = p.filename().string();
+        for (const auto& e : fs::directory_iterator(dir, ec)) {
+            string name = e.path().filename().string();
+            if (e.is_regular_file(ec) && !isBatchOutput(name) && wildMatch(pat.c_str(), name.c_str())) {
+                out.push_back(e.path().string());
+            }
+        }
+    } else if (fs::is_regular_file(spec, ec)) {
+        out.push_back(spec);
+    }
+
+    sort(out.begin(), out.end());
+    return out;
+}
+
+// "data/20240102_Tse.bin.gz" -> "20240102_Tse"
+static string outputStem(const string& path) {
+    string name = fs::path(path).filename().string();
+    static const char* exts[] = {".gz", ".zst", ".bin"};
+    for (const char* e : exts) {
+        if (endsWith(name, e)) name.resize(name.size() - strlen(e));
+    }
+    return name;
+}
+
+// ---- split points ---------------------------------------------------------------
+
+// Length of a valid message starting at buf[pos], 0 if none
+static int validMsgAt(const vector<uint8_t>& buf, size_t pos) {
+    if (buf[pos] != 0x1B) return 0;
+    int len = 0;
+    string fmt, ver;
+    if (!peekHeaderLenFmtVer(buf, (int)pos, len, fmt, ver)) return 0;
+    if (fmt == "01") len = FORMAT_01_LEN;
+    if (len <= 0 || len > MAX_MSG_LEN || pos + len > buf.size()) return 0;
+    if (buf[pos + len - 2] != 0x0D || buf[pos + len - 1] != 0x0A) return 0;
+    return len;
+}
+
+// First offset >= off where SYNC_CHAIN messages parse back to back.
+// Returns limit when none is found (the range is merged into its neighbour).
+static uint64_t findSyncPoint(const string& path, uint64_t off, uint64_t limit) {
+    ifstream fin(path, ios::binary);
+    vector<uint8_t> win(SYNC_WINDOW);
+    fin.seekg((streamoff)off);
+    fin.read((char*)win.data(), (streamsize)win.size());
+    win.resize((size_t)fin.gcount());
+
+    for (size_t p = 0; p < win.size(); ++p) {
+        size_t q = p;
+        int chain = 0;
+        while (chain < SYNC_CHAIN && q < win.size()) {
+            int len = validMsgAt(win, q);
+            if (len == 0) break;
+            q += len;
+            chain++;
+        }
+        // Only a full chain counts: one ESC-framed run can occur inside
+        // payload bytes. Near the window / file end there is no split.
+        if (chain == SYNC_CHAIN) return min<uint64_t>(off + p, limit);
+    }
+    return limit;
+}
+
+// ---- per-file state -------------------------------------------------------------
+
+struct PartResult {
+    int  rows01 = 0;
+    int  rows06 = 0;
+    bool ok = true;
+};
+
+struct FileJob {
+    string path;
+    string out01, out06;
+    bool   splittable = false;
+    vector<pair<uint64_t, uint64_t>> ranges;
+    vector<PartResult> parts;
+    atomic<int> remaining{0};
+    bool ok = true;
+};
+
+struct BatchState {
+    const BatchOptions& opt;
+    WorkStealingPool&   pool;
+    MemoryBudget&       budget;
+    WriteRing&          ring;
+    atomic<uint64_t>    bytesDone{0};
+    atomic<int>         filesDone{0};
+    atomic<uint64_t>    rows01{0}, rows06{0};
+    mutex               logMu;
+    mutex               arenaMu;
+    ArenaStats          arena;              // summed over part tasks
+
+    BatchState(const BatchOptions& o, WorkStealingPool& p, MemoryBudget& b, WriteRing& r)
+        : opt(o), pool(p), budget(b), ring(r) {}
+};
+
+static string partPath(const string& out, size_t k) {
+    return k == 0 ? out : out + ".part" + to_string(k);
+}
+
+// Append parts 1..N-1 to the part-0 file and remove them
+static bool mergeParts(const FileJob& job, const string& out, bool fmt01, const string& header) {
+    int total = 0, first = 0;
+    for (const auto& p : job.parts) total += fmt01 ? p.rows01 : p.rows06;
+    first = fmt01 ? job.parts[0].rows01 : job.parts[0].rows06;
+
+    bool ok = true;
+    if (job.parts.size() > 1) {
+        ofstream fout(out, ios::binary | ios::app);
+        // Part 0 writes the header lazily; if it had no rows the file is empty
+        if (first == 0 && total > 0) fout << header << "\n";
+        for (size_t k = 1; k < job.parts.size(); ++k) {
+            string pp = partPath(out, k);
+            {
+                ifstream fin(pp, ios::binary);
+                if (!fin) {
+                    cerr << "[ERROR] missing part " << pp << "\n";
+                    ok = false;
+                    continue;
+                }
+                if (fin.peek() != ifstream::traits_type::eof()) fout << fin.rdbuf();
+            }
+            error_code ec;
+            fs::remove(pp, ec);
+        }
+        ok = ok && (bool)fout;
+    }
+    return ok;
+}
+
+static void finishFile(BatchState& st, FileJob& job) {
+    TseFmt01Parser p01;
+    TseFmt06Parser p06;
+    for (const auto& p : job.parts) job.ok = job.ok && p.ok;
+    job.ok = mergeParts(job, job.out01, true, p01.csvHeader()) && job.ok;
+    job.ok = mergeParts(job, job.out06, false, p06.csvHeader()) && job.ok;
+
+    int r01 = 0, r06 = 0;
+    for (const auto& p : job.parts) { r01 += p.rows01; r06 += p.rows06; }
+    st.rows01 += r01;
+    st.rows06 += r06;
+    st.filesDone++;
+
+    lock_guard<mutex> lk(st.logMu);
+    cout << "[BATCH] " << job.path << (job.ok ? "" : " FAILED")
+         << " parts=" << job.parts.size()
+         << " fmt01=" << r01 << " fmt06=" << r06 << "\n";
+}
+
+// Estimated working set of one part task
+static size_t partMemory(const BatchOptions& opt, bool compressed) {
+    size_t m = READ_CHUNK + 2 * (size_t)max(opt.io.bufferCount, 2) * opt.io.bufferSize + 64 * 1024
+             + opt.arena.chunkSize;
+    if (compressed) m += (size_t)max(opt.decodeThreads, 1) * 8 * 1024 * 1024;
+    return m;
+}
+
+static void runPart(BatchState& st, FileJob& job, size_t k) {
+    const size_t mem = partMemory(st.opt, !job.splittable);
+    st.budget.acquire(mem);
+
+    PartResult& res = job.parts[k];
+    unique_ptr<AsyncSink> out01 = st.ring.openSink(partPath(job.out01, k), st.opt.io);
+    unique_ptr<AsyncSink> out06 = st.ring.openSink(partPath(job.out06, k), st.opt.io);
+
+    if (out01 && out06) {
+        Arena arena(st.opt.arena);
+        TseFmt01Parser p01;
+        TseFmt06Parser p06;
+        p01.setArena(&arena);
+        p06.setArena(&arena);
+        StreamFramer framer;
+        Tse01Record rec01;
+        Tse06Record rec06;
+
+        auto onMessage = [&](const vector<uint8_t>& msg, const string& version) {
+            if (version == "01") {
+                rec01.checksumOK = true;
+                if (p01.parseOneMSG01(msg.data(), (int)msg.size(), &rec01)) {
+                    if (k == 0 && res.rows01 == 0) { out01->write(p01.csvHeader()); out01->put('\n'); }
+                    string_view line = p01.recToCsv01(&rec01, arena);
+                    out01->write(line.data(), line.size());
+                    out01->put('\n');
+                    res.rows01++;
+                }
+                if (!rec01.checksumOK) {
+                    ostringstream oss;
+                    oss << "[ERROR] " << job.path << " format: 01 seq: " << rec01.seq
+                        << " stockId: " << rec01.stockId
+                        << " calculateXor: 0x" << uppercase << hex
+                        << setw(2) << setfill('0') << (unsigned) rec01.calculateXor
+                        << " field=0x" << setw(2) << setfill('0') << (unsigned) rec01.checksum
+                        << dec << "\n";
+                    cout << oss.str();
+                }
+            } else if (version == "06") {
+                rec06.checksumOK = true;
+                if (p06.parseOneMSG06(msg.data(), (int)msg.size(), &rec06)) {
+                    if (k == 0 && res.rows06 == 0) { out06->write(p06.csvHeader()); out06->put('\n'); }
+                    string_view line = p06.recToCsv06(&rec06, arena);
+                    out06->write(line.data(), line.size());
+                    out06->put('\n');
+                    res.rows06++;
+                }
+                if (!rec06.checksumOK) {
+                    ostringstream oss;
+                    oss << "[ERROR] " << job.path << " format: 06 seq: " << rec06.seq
+                        << " stockId: " << rec06.stockId
+                        << " calculateXor: 0x" << uppercase << hex
+                        << setw(2) << setfill('0') << (unsigned) rec06.calcXor
+                        << " field=0x" << setw(2) << setfill('0') << (unsigned) rec06.checksum
+                        << dec << "\n";
+                    cout << oss.str();
+                }
+            }
+        };
+
+        vector<uint8_t> chunk(READ_CHUNK);
+        if (job.splittable) {
+            ifstream fin(job.path, ios::binary);
+            uint64_t pos = job.ranges[k].first, end = job.ranges[k].second;
+            fin.seekg((streamoff)pos);
+            while (fin && pos < end) {
+                size_t want = (size_t)min<uint64_t>(READ_CHUNK, end - pos);
+                fin.read((char*)chunk.data(), (streamsize)want);
+                streamsize got = fin.gcount();
+                if (got <= 0) break;
+                framer.feed(chunk.data(), (size_t)got, onMessage);
+                arena.reset();
+                pos += got;
+                st.bytesDone += got;
+            }
+            res.ok = (pos >= end);
+        } else {
+            unique_ptr<InputSource> src = InputSource::open(job.path, st.opt.decodeThreads);
+            res.ok = (bool)src;
+            uint64_t lastIn = 0;
+            while (src) {
+                long got = src->read(chunk.data(), chunk.size());
+                if (got < 0) { res.ok = false; break; }
+                if (got == 0) break;
+                framer.feed(chunk.data(), (size_t)got, onMessage);
+                arena.reset();
+                uint64_t in = src->metrics().compressedBytes;
+                st.bytesDone += in - lastIn;
+                lastIn = in;
+            }
+        }
+
+        const ArenaStats& as = arena.stats();
+        lock_guard<mutex> lk(st.arenaMu);
+        st.arena.allocs     += as.allocs;
+        st.arena.bytes      += as.bytes;
+        st.arena.resets     += as.resets;
+        st.arena.chunks     += as.chunks;
+        st.arena.reserved   += as.reserved;
+        st.arena.hugeChunks += as.hugeChunks;
+        st.arena.peakBatch   = max(st.arena.peakBatch, as.peakBatch);
+    } else {
+        res.ok = false;
+    }
+
+    if (out01) res.ok = out01->close() && res.ok;
+    if (out06) res.ok = out06->close() && res.ok;
+    out01.reset();
+    out06.reset();
+    st.budget.release(mem);
+
+    if (--job.remaining == 0) finishFile(st, job);
+}
+
+// Plan one file: pick split points, then fan out its parts
+static void planFile(BatchState& st, FileJob& job) {
+    error_code ec;
+    uint64_t size = fs::file_size(job.path, ec);
+    if (ec) size = 0;
+
+    {
+        unique_ptr<InputSource> probe = InputSource::open(job.path);
+        job.splittable = probe && probe->metrics().codec == "raw";
+    }
+
+    job.ranges.clear();
+    if (job.splittable && size > st.opt.splitBytes && st.opt.splitBytes > 0) {
+        uint64_t begin = 0;
+        for (uint64_t cut = st.opt.splitBytes; cut < size; cut += st.opt.splitBytes) {
+            uint64_t sync = findSyncPoint(job.path, cut, size);
+            if (sync <= begin || sync >= size) continue;
+            job.ranges.emplace_back(begin, sync);
+            begin = sync;
+        }
+        job.ranges.emplace_back(begin, size);
+    } else {
+        job.ranges.emplace_back(0, size);
+    }
+
+    job.parts.assign(job.ranges.size(), PartResult());
+    job.remaining = (int)job.ranges.size();
+    for (size_t k = 0; k < job.ranges.size(); ++k) {
+        st.pool.submit([&st, &job, k] { runPart(st, job, k); });
+    }
+}
+
+int runBatch(const vector<string>& inputs, const BatchOptions& optIn) {
+    BatchOptions opt = optIn;
+    if (opt.threads <= 0) opt.threads = max(1u, thread::hardware_concurrency());
+
+    error_code ec;
+    fs::create_directories(opt.outDir, ec);
+
+    uint64_t totalBytes = 0;
+    vector<unique_ptr<FileJob>> jobs;
+    // a.bin, a.bin.gz, a.zst... share the stem "a": those keep their full
+    // file name (unique, inputs come from one directory)
+    map<string, int> stems;
+    for (const auto& in : inputs) stems[outputStem(in)]++;
+    set<string> used;
+    for (const auto& in : inputs) {
+        unique_ptr<FileJob> job(new FileJob());
+        job->path = in;
+        string name = outputStem(in);
+        if (stems[name] > 1) name = fs::path(in).filename().string();
+        if (!used.insert(name).second) {
+            cerr << "[ERROR] more than one input writes " << name << "_fmt0x.csv\n";
+            return 1;
+        }
+        string stem = (fs::path(opt.outDir) / name).string();
+        job->out01 = stem + "_fmt01.csv";
+        job->out06 = stem + "_fmt06.csv";
+        totalBytes += fs::file_size(in, ec);
+        jobs.push_back(std::move(job));
+    }
+
+    WriteRing ring;
+    ring.start();
+    MemoryBudget budget(opt.memoryBudget);
+    WorkStealingPool pool(opt.threads);
+    BatchState st(opt, pool, budget, ring);
+
+    cout << "[BATCH] files=" << jobs.size() << " threads=" << opt.threads
+         << " budgetMB=" << opt.memoryBudget / (1024 * 1024)
+         << " splitMB=" << opt.splitBytes / (1024 * 1024) << "\n";
+
+    auto t0 = chrono::steady_clock::now();
+    for (auto& j : jobs) {
+        FileJob* job = j.get();
+        pool.submit([&st, job] { planFile(st, *job); });
+    }
+
+    // Progress reporter
+    atomic<bool> done{false};
+    thread progress([&] {
+        int tick = 0;
+        while (!done.load()) {
+            this_thread::sleep_for(chrono::milliseconds(200));
+            if (++tick % 5 != 0 || done.load()) continue;
+            double sec = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+            uint64_t b = st.bytesDone.load();
+            lock_guard<mutex> lk(st.logMu);
+            cout << "[BATCH] progress files " << st.filesDone.load() << "/" << jobs.size()
+                 << " " << fixed << setprecision(1)
+                 << (totalBytes ? 100.0 * b / totalBytes : 100.0) << "% "
+                 << b / sec / (1024 * 1024) << " MB/s" << defaultfloat << "\n";
+        }
+    });
+
+    pool.wait();
+    done = true;
+    progress.join();
+    ring.stop();
+
+    double sec = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    int failed = 0;
+    for (const auto& j : jobs) if (!j->ok) failed++;
+
+    cout << "[BATCH] Done. files=" << jobs.size() << " failed=" << failed
+         << " fmt01=" << st.rows01.load() << " fmt06=" << st.rows06.load() << "\n";
+    cout << "[METRICS] batch bytes=" << st.bytesDone.load()
+         << " sec=" << fixed << setprecision(3) << sec
+         << " MB/s=" << (sec > 0 ? st.bytesDone.load() / sec / (1024 * 1024) : 0.0)
+         << " steals=" << pool.steals()
+         << " peakMemMB=" << budget.peak() / (1024.0 * 1024.0)
+         << defaultfloat << "\n";
+    cout << "[METRICS] arena allocs=" << st.arena.allocs
+         << " bytes=" << st.arena.bytes
+         << " batches=" << st.arena.resets
+         << " peakBatchKB=" << fixed << setprecision(1) << st.arena.peakBatch / 1024.0
+         << " chunks=" << st.arena.chunks
+         << " reservedKB=" << st.arena.reserved / 1024.0
+         << " hugeChunks=" << st.arena.hugeChunks
+         << defaultfloat << "\n";
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,42 @@
+#ifndef BATCH_DRIVER_H
+#define BATCH_DRIVER_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include "AsyncWriter.h"
+#include "Arena.h"
+
+// Batch mode: parse many capture files concurrently.
+//
+// Every input gets its own <outDir>/<name>_fmt01.csv and _fmt06.csv, where
+// name is the file name without .bin / .gz / .zst, or the whole file name
+// when several inputs would share it (a.bin and a.bin.gz). Unlike
+// single-file mode there is no 100000-row limit: every row is written.
+// Raw captures larger than splitBytes are cut into byte ranges aligned to
+// message boundaries; ranges are parsed in parallel into part files and
+// concatenated in order when the last range of a file finishes. All tasks
+// run on one WorkStealingPool and reserve their working memory from a
+// shared MemoryBudget before starting.
+
+struct BatchOptions {
+    int         threads     = 0;                  // 0: hardware_concurrency
+    size_t      memoryBudget = 512ull * 1024 * 1024;
+    size_t      splitBytes  = 256ull * 1024 * 1024;
+    std::string outDir      = ".";
+    int         decodeThreads = 1;                // for .zst inputs
+    AsyncWriterOptions io;
+    ArenaOptions arena;                           // one arena per part task
+};
+
+// Expand a directory (its .bin / .gz / .zst files) or a glob pattern
+// ("data/*.bin", wildcards in the file name only) into a sorted list of
+// paths. Outputs of an earlier batch run (*_fmt01.csv, *_fmt06.csv and
+// their .part files) are never taken as inputs.
+std::vector<std::string> expandInputs(const std::string& spec);
+
+// Process all inputs; returns 0 if every file succeeded.
+int runBatch(const std::vector<std::string>& inputs, const BatchOptions& opt);
+
+#endif // BATCH_DRIVER_H
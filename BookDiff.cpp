@@ -0,0 +1,306 @@
+#include "BookDiff.h"
+#include "AsyncWriter.h"
+#include "Checkpoint.h"
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+using namespace std;
+
+static const char* DIFF_HEADER = "Stock ID,Match Time,Side,Level,Price,Qty\n";
+
+// %.4f without trailing zeros ("585.5000" -> "585.5", "0.0000" -> "0")
+static int formatPx(char* out, size_t cap, double px) {
+    int n = snprintf(out, cap, "%.4f", px);
+    if (n <= 0 || (size_t)n >= cap) return n;
+    while (n > 0 && out[n - 1] == '0') n--;
+    if (n > 0 && out[n - 1] == '.') n--;
+    out[n] = '\0';
+    return n;
+}
+
+static void copyTime(char* dst, const string& t) {
+    size_t n = t.size() < 23 ? t.size() : 23;
+    memcpy(dst, t.data(), n);
+    dst[n] = '\0';
+}
+
+// ---- writer -----------------------------------------------------------------
+
+BookDiffWriter::BookDiffWriter(AsyncSink* out, uint32_t snapshotEvery, bool resumed)
+    : _out(out), _snapEvery(snapshotEvery ? snapshotEvery : 1000000)
+{
+    if (!resumed) _out->write(DIFF_HEADER);
+}
+
+void BookDiffWriter::event(const Tse06Record& r, char side, int level, double px, uint32_t qty) {
+    char line[160];
+    char pxs[40];
+    formatPx(pxs, sizeof(pxs), px);
+    int n;
+    if (_first) {
+        n = snprintf(line, sizeof(line), "%s,%s,%c,%d,%s,%u\n", r.stockId.c_str(),
+                     r.matchTime.c_str(), side, level, pxs, (unsigned)qty);
+        _first = false;
+    } else {
+        n = snprintf(line, sizeof(line), ",,%c,%d,%s,%u\n", side, level, pxs, (unsigned)qty);
+    }
+    if (n > 0) _out->write(line, (size_t)n < sizeof(line) ? (size_t)n : sizeof(line) - 1);
+    _events++;
+}
+
+// An event without price / quantity ('-' nothing changed, 'X' no levels)
+void BookDiffWriter::mark(const Tse06Record& r, char side) {
+    char tail[8] = {',', side, ',', '0', ',', ',', '\n'};
+    if (_first) {
+        _out->write(r.stockId);
+        _out->put(',');
+        _out->write(r.matchTime);
+        _first = false;
+    } else {
+        _out->put(',');
+    }
+    _out->write(tail, 7);
+    _events++;
+}
+
+static bool noLevels(const Tse06Record& r) {
+    for (int i = 0; i < 5; ++i) {
+        if (r.bidPx[i] != 0.0 || r.bidQty[i] != 0 || r.askPx[i] != 0.0 || r.askQty[i] != 0) return false;
+    }
+    return true;
+}
+
+void BookDiffWriter::append(const Tse06Record& r) {
+    uint32_t idx;
+    auto it = _symIdx.find(r.stockId);
+    if (it == _symIdx.end()) {
+        idx = (uint32_t)_syms.size();
+        _symIdx.emplace(r.stockId, idx);
+        _syms.push_back(r.stockId);
+        _books.push_back(Book{});
+    } else {
+        idx = it->second;
+    }
+    Book& b = _books[idx];
+
+    _first = true;
+    if (noLevels(r)) {
+        // Trade-only / deferred message: the row shows no levels, the book
+        // is kept so the next message diffs against it
+        for (int i = 0; i < 5; ++i) {
+            if (b.bidPx[i] != 0.0 || b.bidQty[i] != 0 || b.askPx[i] != 0.0 || b.askQty[i] != 0) {
+                mark(r, 'X');
+                break;
+            }
+        }
+    } else {
+        for (int i = 0; i < 5; ++i) {
+            if (r.bidPx[i] != b.bidPx[i] || r.bidQty[i] != b.bidQty[i]) {
+                event(r, 'B', i + 1, r.bidPx[i], r.bidQty[i]);
+                b.bidPx[i] = r.bidPx[i];
+                b.bidQty[i] = r.bidQty[i];
+            }
+        }
+        for (int i = 0; i < 5; ++i) {
+            if (r.askPx[i] != b.askPx[i] || r.askQty[i] != b.askQty[i]) {
+                event(r, 'A', i + 1, r.askPx[i], r.askQty[i]);
+                b.askPx[i] = r.askPx[i];
+                b.askQty[i] = r.askQty[i];
+            }
+        }
+    }
+    if (r.lastPx != b.lastPx || r.lastQty != b.lastQty) {
+        event(r, 'T', 0, r.lastPx, r.lastQty);
+        b.lastPx = r.lastPx;
+        b.lastQty = r.lastQty;
+    }
+    // Nothing changed but the row still exists (time / bitmaps only)
+    if (_first) mark(r, '-');
+    copyTime(b.time, r.matchTime);
+    _messages++;
+
+    if (++_sinceSnap >= _snapEvery) writeSnapshot(r.matchTime);
+}
+
+void BookDiffWriter::writeSnapshot(const string& time) {
+    char line[160];
+    char pxs[40];
+    int n = snprintf(line, sizeof(line), ",%s,S,%zu,,\n", time.c_str(), _syms.size());
+    if (n > 0) _out->write(line, (size_t)n < sizeof(line) ? (size_t)n : sizeof(line) - 1);
+
+    for (size_t s = 0; s < _syms.size(); ++s) {
+        const Book& b = _books[s];
+        const char* id = _syms[s].c_str();
+        for (int i = 0; i < 5; ++i) {
+            if (b.bidPx[i] == 0.0 && b.bidQty[i] == 0) continue;
+            formatPx(pxs, sizeof(pxs), b.bidPx[i]);
+            n = snprintf(line, sizeof(line), "%s,%s,b,%d,%s,%u\n", id, b.time, i + 1, pxs, (unsigned)b.bidQty[i]);
+            if (n > 0) _out->write(line, (size_t)n < sizeof(line) ? (size_t)n : sizeof(line) - 1);
+        }
+        for (int i = 0; i < 5; ++i) {
+            if (b.askPx[i] == 0.0 && b.askQty[i] == 0) continue;
+            formatPx(pxs, sizeof(pxs), b.askPx[i]);
+            n = snprintf(line, sizeof(line), "%s,%s,a,%d,%s,%u\n", id, b.time, i + 1, pxs, (unsigned)b.askQty[i]);
+            if (n > 0) _out->write(line, (size_t)n < sizeof(line) ? (size_t)n : sizeof(line) - 1);
+        }
+        // Always present: one line per symbol even with an empty book
+        formatPx(pxs, sizeof(pxs), b.lastPx);
+        n = snprintf(line, sizeof(line), "%s,%s,t,0,%s,%u\n", id, b.time, pxs, (unsigned)b.lastQty);
+        if (n > 0) _out->write(line, (size_t)n < sizeof(line) ? (size_t)n : sizeof(line) - 1);
+    }
+    _sinceSnap = 0;
+    _snapshots++;
+}
+
+void BookDiffWriter::saveState(StateWriter& w) const {
+    w.put(_snapEvery);
+    w.put<uint64_t>(_syms.size());
+    for (const string& s : _syms) w.putString(s);
+    w.putVector(_books);
+    w.put(_sinceSnap);
+    w.put(_messages);
+    w.put(_events);
+    w.put(_snapshots);
+}
+
+bool BookDiffWriter::loadState(StateReader& r) {
+    uint32_t snapEvery = 0;
+    uint64_t n = 0;
+    if (!r.get(snapEvery) || snapEvery != _snapEvery || !r.get(n)) return false;
+    _syms.clear();
+    _symIdx.clear();
+    for (uint64_t i = 0; i < n && r.ok(); ++i) {
+        string s;
+        r.getString(s);
+        _symIdx.emplace(s, (uint32_t)_syms.size());
+        _syms.push_back(std::move(s));
+    }
+    r.getVector(_books);
+    r.get(_sinceSnap);
+    r.get(_messages);
+    r.get(_events);
+    r.get(_snapshots);
+    return r.ok() && _books.size() == _syms.size();
+}
+
+// ---- reader -----------------------------------------------------------------
+
+bool BookDiffReader::open(const string& path) {
+    _in.open(path, ios::binary);
+    if (!_in || !getline(_in, _line)) return false;
+    _lineNo = 1;
+    return _line + "\n" == DIFF_HEADER;
+}
+
+// Next line split into its 6 columns
+bool BookDiffReader::readLine() {
+    if (_pending) { _pending = false; return true; }
+    if (!getline(_in, _line)) return false;
+    _lineNo++;
+    _cols.clear();
+    size_t b = 0;
+    while (true) {
+        size_t e = _line.find(',', b);
+        if (e == string::npos) { _cols.push_back(_line.substr(b)); break; }
+        _cols.push_back(_line.substr(b, e - b));
+        b = e + 1;
+    }
+    if (_cols.size() != 6 || _cols[2].size() != 1) { _corrupt = true; return false; }
+    return true;
+}
+
+static bool applyEvent(BookDiffWriter::Book& b, char side, int level, double px, uint32_t qty) {
+    if (side == 'T' || side == 't') { b.lastPx = px; b.lastQty = qty; return level == 0; }
+    if (level < 1 || level > 5) return false;
+    if (side == 'B' || side == 'b') { b.bidPx[level - 1] = px; b.bidQty[level - 1] = qty; return true; }
+    if (side == 'A' || side == 'a') { b.askPx[level - 1] = px; b.askQty[level - 1] = qty; return true; }
+    return false;
+}
+
+static bool sameBook(const BookDiffWriter::Book& x, const BookDiffWriter::Book& y) {
+    for (int i = 0; i < 5; ++i) {
+        if (x.bidPx[i] != y.bidPx[i] || x.bidQty[i] != y.bidQty[i]) return false;
+        if (x.askPx[i] != y.askPx[i] || x.askQty[i] != y.askQty[i]) return false;
+    }
+    return x.lastPx == y.lastPx && x.lastQty == y.lastQty && strcmp(x.time, y.time) == 0;
+}
+
+// Marker already read: collect the snapshot, compare with the books built
+// so far, then continue from it
+bool BookDiffReader::applySnapshot(size_t symbols) {
+    unordered_map<string, BookDiffWriter::Book> snap;
+    while (readLine()) {
+        char side = _cols[2][0];
+        if (side != 'b' && side != 'a' && side != 't') { _pending = true; break; }
+        BookDiffWriter::Book& b = snap[_cols[0]];
+        copyTime(b.time, _cols[1]);
+        if (!applyEvent(b, side, atoi(_cols[3].c_str()), atof(_cols[4].c_str()),
+                        (uint32_t)strtoul(_cols[5].c_str(), nullptr, 10))) {
+            _corrupt = true;
+            return false;
+        }
+    }
+    if (_corrupt) return false;
+
+    if (snap.size() != symbols) _snapMismatch++;
+    for (const auto& kv : snap) {
+        auto it = _books.find(kv.first);
+        if (it == _books.end() || !sameBook(it->second, kv.second)) {
+            _snapMismatch++;
+        }
+    }
+    _books.swap(snap);
+    _snapshots++;
+    return true;
+}
+
+bool BookDiffReader::next(Tse06Record& r) {
+    BookDiffWriter::Book* cur = nullptr;
+    bool levels = true;
+    while (readLine()) {
+        const char side = _cols[2][0];
+        if (side == 'S') {
+            if (cur) { _pending = true; break; }
+            if (!applySnapshot((size_t)strtoul(_cols[3].c_str(), nullptr, 10))) return false;
+            continue;
+        }
+        if ((side < 'A' || side > 'Z') && side != '-') {
+            _corrupt = true;            // snapshot line outside a snapshot
+            return false;
+        }
+        if (!_cols[0].empty()) {
+            // A new message; finish the current one first
+            if (cur) { _pending = true; break; }
+            r.stockId = _cols[0];
+            r.matchTime = _cols[1];
+            auto it = _books.find(r.stockId);
+            if (it == _books.end()) {
+                it = _books.emplace(r.stockId, BookDiffWriter::Book{}).first;
+            }
+            cur = &it->second;
+            copyTime(cur->time, r.matchTime);
+            if (side == '-') continue;
+        } else if (!cur || side == '-') {
+            _corrupt = true;
+            return false;
+        }
+        if (side == 'X') { levels = false; continue; }
+        if (!applyEvent(*cur, side, atoi(_cols[3].c_str()), atof(_cols[4].c_str()),
+                        (uint32_t)strtoul(_cols[5].c_str(), nullptr, 10))) {
+            _corrupt = true;
+            return false;
+        }
+    }
+    if (!cur) return false;
+
+    for (int i = 0; i < 5; ++i) {
+        r.bidPx[i] = levels ? cur->bidPx[i] : 0.0;
+        r.bidQty[i] = levels ? cur->bidQty[i] : 0;
+        r.askPx[i] = levels ? cur->askPx[i] : 0.0;
+        r.askQty[i] = levels ? cur->askQty[i] : 0;
+    }
+    r.lastPx = cur->lastPx;
+    r.lastQty = cur->lastQty;
+    return true;
+}
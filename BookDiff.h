@@ -0,0 +1,111 @@
+#ifndef BOOK_DIFF_H
+#define BOOK_DIFF_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <fstream>
+#include <cstdint>
+
+#include "TseFmt06Parser.h"
+
+class AsyncSink;
+class StateWriter;
+class StateReader;
+
+// Change-only CSV of Format 06 rows (main --diff -> out_fmt06_diff.csv).
+//
+// Each message is compared with the previous row of the same symbol and
+// only the changed bid / ask levels and trade are written, one event per
+// line:
+//
+//   Stock ID,Match Time,Side,Level,Price,Qty
+//   2330,09:00:01.000250,B,1,585.5,12     first event of a message
+//   ,,A,3,586,40                          same message (blank = above)
+//   2317,09:00:01.000300,-,0,,            message with nothing changed
+//
+// Side: B / A (level 1-5), T (last trade, level 0), X (the row has no
+// levels: trade-only or deferred message; the book is kept and the next
+// message diffs against it), - (nothing changed). Prices are the %.4f
+// values with trailing zeros dropped, so rows rebuild byte-exact.
+//
+// Every N messages a snapshot of all books is written: a marker line
+// ",TIME,S,SYMBOLS,," followed by the non-empty levels of every symbol
+// with lower-case sides (b / a / t) and the symbol's last match time. A
+// reader may start at any snapshot; a reader coming from the start can
+// check its books against it. The binary counterpart is BookLog.h.
+
+class BookDiffWriter {
+public:
+    // out must stay open until the last append(). resumed: out already
+    // holds the stream up to a checkpoint; loadState() follows.
+    explicit BookDiffWriter(AsyncSink* out, uint32_t snapshotEvery = 1000000,
+                            bool resumed = false);
+
+    void append(const Tse06Record& r);
+
+    uint64_t messages()  const { return _messages; }
+    uint64_t events()    const { return _events; }
+    uint64_t snapshots() const { return _snapshots; }
+
+    // Checkpoint: books of every symbol, counters
+    void saveState(StateWriter& w) const;
+    bool loadState(StateReader& r);
+
+    // Row values of one symbol (what the full CSV row prints)
+    struct Book {
+        double   bidPx[5];
+        uint32_t bidQty[5];
+        double   askPx[5];
+        uint32_t askQty[5];
+        double   lastPx;
+        uint32_t lastQty;
+        char     time[24];      // match time of the last row, NUL terminated
+    };
+
+private:
+    void writeSnapshot(const std::string& time);
+    void event(const Tse06Record& r, char side, int level, double px, uint32_t qty);
+    void mark(const Tse06Record& r, char side);
+
+    AsyncSink*                      _out;
+    uint32_t                        _snapEvery;
+    std::unordered_map<std::string, uint32_t> _symIdx;
+    std::vector<std::string>        _syms;
+    std::vector<Book>               _books;
+    bool                            _first = true;   // next event starts a message
+    uint32_t                        _sinceSnap = 0;
+    uint64_t                        _messages = 0;
+    uint64_t                        _events = 0;
+    uint64_t                        _snapshots = 0;
+};
+
+class BookDiffReader {
+public:
+    bool open(const std::string& path);
+
+    // Next message as a full row (stock id, levels, trade, match time).
+    // Returns false at end of stream or on a malformed line (see corrupt()).
+    bool next(Tse06Record& r);
+
+    uint64_t snapshots()        const { return _snapshots; }
+    uint64_t snapshotMismatch() const { return _snapMismatch; }   // books that disagreed
+    uint64_t lineNo()           const { return _lineNo; }
+    bool corrupt() const { return _corrupt; }
+
+private:
+    bool readLine();
+    bool applySnapshot(size_t symbols);
+
+    std::ifstream _in;
+    std::string   _line;
+    std::vector<std::string> _cols;
+    bool          _pending = false;   // _cols holds an unprocessed line
+    std::unordered_map<std::string, BookDiffWriter::Book> _books;
+    uint64_t      _snapshots = 0;
+    uint64_t      _snapMismatch = 0;
+    uint64_t      _lineNo = 0;
+    bool          _corrupt = false;
+};
+
+#endif // BOOK_DIFF_H
@@ -0,0 +1,539 @@
+#include "BookLog.h"
+#include "AsyncWriter.h"
+#include "Checkpoint.h"
+#include <fstream>
+#include <cstring>
+#include <cmath>
+
+using namespace std;
+
+static const char LOG_MAGIC[8] = {'T','S','E','B','L','O','G','1'};
+static const char IDX_MAGIC[8] = {'T','S','E','B','I','D','X','1'};
+
+enum : uint8_t {
+    TAG_SYMDEF   = 1,
+    TAG_UPDATE   = 2,
+    TAG_KEYFRAME = 3,
+    TAG_INDEX    = 4,
+};
+
+// Change mask bits
+enum : uint32_t {
+    CH_TIME     = 1u << 0,
+    CH_BITMAPS  = 1u << 1,
+    CH_CUMQTY   = 1u << 2,
+    CH_LASTPX   = 1u << 3,
+    CH_LASTQTY  = 1u << 4,
+    CH_BIDPX0   = 1u << 5,   // 5 bits
+    CH_BIDQTY0  = 1u << 10,  // 5 bits
+    CH_ASKPX0   = 1u << 15,  // 5 bits
+    CH_ASKQTY0  = 1u << 20,  // 5 bits
+    CH_MSGLEN   = 1u << 25,
+    CH_HEADER   = 1u << 26,
+    CH_BADSUM   = 1u << 27,  // not a change bit: checksumOK == false
+};
+
+// ---- conversions ------------------------------------------------------------
+
+int64_t pxToTicks(double px) {
+    return (int64_t)llround(px * 10000.0);
+}
+
+// Same arithmetic as parsePrice_fromBCD5 so the double is bit-identical
+double ticksToPx(int64_t ticks) {
+    return (double)(ticks / 10000) + (double)(ticks % 10000) / 10000.0;
+}
+
+int64_t matchTimeToUs(const string& s) {
+    if (s.size() < 15) return 0;
+    auto d = [&s](int i) { return (int64_t)(s[i] - '0'); };
+    int64_t hh = d(0) * 10 + d(1);
+    int64_t mm = d(3) * 10 + d(4);
+    int64_t ss = d(6) * 10 + d(7);
+    int64_t frac = 0;
+    for (int i = 9; i < 15; ++i) frac = frac * 10 + d(i);
+    return ((hh * 60 + mm) * 60 + ss) * 1000000 + frac;
+}
+
+string usToMatchTime(int64_t us) {
+    char buf[16];
+    int64_t frac = us % 1000000;
+    int64_t sec = us / 1000000;
+    buf[0]  = (char)('0' + sec / 36000);
+    buf[1]  = (char)('0' + sec / 3600 % 10);
+    buf[2]  = ':';
+    buf[3]  = (char)('0' + sec / 600 % 6);
+    buf[4]  = (char)('0' + sec / 60 % 10);
+    buf[5]  = ':';
+    buf[6]  = (char)('0' + sec % 60 / 10);
+    buf[7]  = (char)('0' + sec % 10);
+    buf[8]  = '.';
+    for (int i = 14; i >= 9; --i) { buf[i] = (char)('0' + frac % 10); frac /= 10; }
+    return string(buf, 15);
+}
+
+// "01" -> 0x01 (inverse of bcdToDigitString for one byte)
+static uint8_t digitsToBcd(const string& s) {
+    if (s.size() < 2) return 0;
+    return (uint8_t)(((s[0] - '0') << 4) | ((s[1] - '0') & 0xF));
+}
+
+static string bcdToDigits(uint8_t b) {
+    string s(2, '0');
+    s[0] = (char)('0' + (b >> 4));
+    s[1] = (char)('0' + (b & 0xF));
+    return s;
+}
+
+static uint32_t seqToInt(const string& s) {
+    uint32_t v = 0;
+    for (char c : s) v = v * 10 + (uint32_t)(c - '0');
+    return v;
+}
+
+static string intToSeq(uint32_t v) {
+    string s(8, '0');
+    for (int i = 7; i >= 0; --i) { s[i] = (char)('0' + v % 10); v /= 10; }
+    return s;
+}
+
+void recordToState(const Tse06Record& r, BookState& st) {
+    st.seq         = seqToInt(r.seq);
+    st.timeUs      = matchTimeToUs(r.matchTime);
+    st.itemBitmap  = r.itemBitmap;
+    st.limitBitmap = r.limitBitmap;
+    st.stateBitmap = r.stateBitmap;
+    st.cumQty      = r.cumQty;
+    st.lastPx      = pxToTicks(r.lastPx);
+    st.lastQty     = r.lastQty;
+    for (int i = 0; i < 5; ++i) {
+        st.bidPx[i]  = pxToTicks(r.bidPx[i]);
+        st.bidQty[i] = r.bidQty[i];
+        st.askPx[i]  = pxToTicks(r.askPx[i]);
+        st.askQty[i] = r.askQty[i];
+    }
+    st.msgLen     = (uint16_t)r.msgLen;
+    st.bizType    = digitsToBcd(r.bizType);
+    st.fmtVer     = digitsToBcd(r.fmtVer);
+    st.checksumOK = r.checksumOK;
+}
+
+void stateToRecord(const BookState& st, const string& stockId, Tse06Record& r) {
+    r.esc         = 0x1B;
+    r.msgLen      = st.msgLen;
+    r.bizType     = bcdToDigits(st.bizType);
+    r.fmtCode     = "06";
+    r.fmtVer      = bcdToDigits(st.fmtVer);
+    r.seq         = intToSeq(st.seq);
+    r.stockId     = stockId;
+    r.matchTime   = usToMatchTime(st.timeUs);
+    r.itemBitmap  = st.itemBitmap;
+    r.limitBitmap = st.limitBitmap;
+    r.stateBitmap = st.stateBitmap;
+    r.cumQty      = st.cumQty;
+    r.lastPx      = ticksToPx(st.lastPx);
+    r.lastQty     = st.lastQty;
+    for (int i = 0; i < 5; ++i) {
+        r.bidPx[i]  = ticksToPx(st.bidPx[i]);
+        r.bidQty[i] = st.bidQty[i];
+        r.askPx[i]  = ticksToPx(st.askPx[i]);
+        r.askQty[i] = st.askQty[i];
+    }
+    r.checksum   = 0;
+    r.calcXor    = 0;
+    r.checksumOK = st.checksumOK;
+}
+
+// ---- varint / zigzag --------------------------------------------------------
+
+static inline void putVar(vector<uint8_t>& b, uint64_t v) {
+    while (v >= 0x80) {
+        b.push_back((uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    b.push_back((uint8_t)v);
+}
+
+static inline void putZig(vector<uint8_t>& b, int64_t v) {
+    putVar(b, ((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+}
+
+static inline bool getVar(const uint8_t* d, size_t end, size_t& pos, uint64_t& v) {
+    v = 0;
+    int shift = 0;
+    while (pos < end && shift < 64) {
+        uint8_t c = d[pos++];
+        v |= (uint64_t)(c & 0x7F) << shift;
+        if (!(c & 0x80)) return true;
+        shift += 7;
+    }
+    return false;
+}
+
+static inline bool getZig(const uint8_t* d, size_t end, size_t& pos, int64_t& v) {
+    uint64_t u;
+    if (!getVar(d, end, pos, u)) return false;
+    v = (int64_t)(u >> 1) ^ -(int64_t)(u & 1);
+    return true;
+}
+
+// Encode cur relative to prev (mask + changed fields). Seq is written by the caller.
+static void encodeBody(vector<uint8_t>& b, const BookState& p, const BookState& c) {
+    uint32_t mask = 0;
+    if (c.timeUs != p.timeUs) mask |= CH_TIME;
+    if (c.itemBitmap != p.itemBitmap || c.limitBitmap != p.limitBitmap ||
+        c.stateBitmap != p.stateBitmap) mask |= CH_BITMAPS;
+    if (c.cumQty  != p.cumQty)  mask |= CH_CUMQTY;
+    if (c.lastPx  != p.lastPx)  mask |= CH_LASTPX;
+    if (c.lastQty != p.lastQty) mask |= CH_LASTQTY;
+    for (int i = 0; i < 5; ++i) {
+        if (c.bidPx[i]  != p.bidPx[i])  mask |= CH_BIDPX0  << i;
+        if (c.bidQty[i] != p.bidQty[i]) mask |= CH_BIDQTY0 << i;
+        if (c.askPx[i]  != p.askPx[i])  mask |= CH_ASKPX0  << i;
+        if (c.askQty[i] != p.askQty[i]) mask |= CH_ASKQTY0 << i;
+    }
+    if (c.msgLen != p.msgLen) mask |= CH_MSGLEN;
+    if (c.bizType != p.bizType || c.fmtVer != p.fmtVer) mask |= CH_HEADER;
+    if (!c.checksumOK) mask |= CH_BADSUM;
+
+    putVar(b, mask);
+    if (mask & CH_TIME)    putZig(b, c.timeUs - p.timeUs);
+    if (mask & CH_BITMAPS) {
+        b.push_back(c.itemBitmap);
+        b.push_back(c.limitBitmap);
+        b.push_back(c.stateBitmap);
+    }
+    if (mask & CH_CUMQTY)  putZig(b, (int64_t)c.cumQty - (int64_t)p.cumQty);
+    if (mask & CH_LASTPX)  putZig(b, c.lastPx - p.lastPx);
+    if (mask & CH_LASTQTY) putZig(b, (int64_t)c.lastQty - (int64_t)p.lastQty);
+    for (int i = 0; i < 5; ++i) {
+        if (mask & (CH_BIDPX0 << i))  putZig(b, c.bidPx[i] - p.bidPx[i]);
+        if (mask & (CH_BIDQTY0 << i)) putZig(b, (int64_t)c.bidQty[i] - (int64_t)p.bidQty[i]);
+    }
+    for (int i = 0; i < 5; ++i) {
+        if (mask & (CH_ASKPX0 << i))  putZig(b, c.askPx[i] - p.askPx[i]);
+        if (mask & (CH_ASKQTY0 << i)) putZig(b, (int64_t)c.askQty[i] - (int64_t)p.askQty[i]);
+    }
+    if (mask & CH_MSGLEN)  putVar(b, c.msgLen);
+    if (mask & CH_HEADER) {
+        b.push_back(c.bizType);
+        b.push_back(c.fmtVer);
+    }
+}
+
+// Apply an encoded body on top of st (in place)
+static bool decodeBody(const uint8_t* d, size_t end, size_t& pos, BookState& st) {
+    uint64_t mask;
+    int64_t v;
+    if (!getVar(d, end, pos, mask)) return false;
+
+    if (mask & CH_TIME) {
+        if (!getZig(d, end, pos, v)) return false;
+        st.timeUs += v;
+    }
+    if (mask & CH_BITMAPS) {
+        if (pos + 3 > end) return false;
+        st.itemBitmap  = d[pos++];
+        st.limitBitmap = d[pos++];
+        st.stateBitmap = d[pos++];
+    }
+    if (mask & CH_CUMQTY) {
+        if (!getZig(d, end, pos, v)) return false;
+        st.cumQty = (uint32_t)((int64_t)st.cumQty + v);
+    }
+    if (mask & CH_LASTPX) {
+        if (!getZig(d, end, pos, v)) return false;
+        st.lastPx += v;
+    }
+    if (mask & CH_LASTQTY) {
+        if (!getZig(d, end, pos, v)) return false;
+        st.lastQty = (uint32_t)((int64_t)st.lastQty + v);
+    }
+    for (int i = 0; i < 5; ++i) {
+        if (mask & (CH_BIDPX0 << i)) {
+            if (!getZig(d, end, pos, v)) return false;
+            st.bidPx[i] += v;
+        }
+        if (mask & (CH_BIDQTY0 << i)) {
+            if (!getZig(d, end, pos, v)) return false;
+            st.bidQty[i] = (uint32_t)((int64_t)st.bidQty[i] + v);
+        }
+    }
+    for (int i = 0; i < 5; ++i) {
+        if (mask & (CH_ASKPX0 << i)) {
+            if (!getZig(d, end, pos, v)) return false;
+            st.askPx[i] += v;
+        }
+        if (mask & (CH_ASKQTY0 << i)) {
+            if (!getZig(d, end, pos, v)) return false;
+            st.askQty[i] = (uint32_t)((int64_t)st.askQty[i] + v);
+        }
+    }
+    if (mask & CH_MSGLEN) {
+        uint64_t u;
+        if (!getVar(d, end, pos, u)) return false;
+        st.msgLen = (uint16_t)u;
+    }
+    if (mask & CH_HEADER) {
+        if (pos + 2 > end) return false;
+        st.bizType = d[pos++];
+        st.fmtVer  = d[pos++];
+    }
+    st.checksumOK = !(mask & CH_BADSUM);
+    return true;
+}
+
+// ---- writer -----------------------------------------------------------------
+
+BookLogWriter::BookLogWriter(AsyncSink* out, uint32_t keyframeEvery, bool resumed)
+    : _out(out), _keyEvery(keyframeEvery ? keyframeEvery : 65536)
+{
+    _buf.reserve(256);
+    if (resumed) return;
+    _buf.assign(LOG_MAGIC, LOG_MAGIC + 8);
+    emit();
+}
+
+void BookLogWriter::emit() {
+    _out->write((const char*)_buf.data(), _buf.size());
+    _offset += _buf.size();
+    _buf.clear();
+}
+
+void BookLogWriter::writeKeyframe(uint32_t seq, int64_t timeUs) {
+    _index.push_back(IndexEntry{_offset, seq, timeUs});
+
+    static const BookState ZERO{};
+    _buf.push_back(TAG_KEYFRAME);
+    putVar(_buf, _prevSeq);
+    putVar(_buf, _syms.size());
+    for (size_t i = 0; i < _syms.size(); ++i) {
+        _buf.push_back((uint8_t)_syms[i].size());
+        _buf.insert(_buf.end(), _syms[i].begin(), _syms[i].end());
+        putVar(_buf, _states[i].seq);
+        encodeBody(_buf, ZERO, _states[i]);
+        if (_buf.size() >= 64 * 1024) emit();
+    }
+    emit();
+    _sinceKey = 0;
+}
+
+void BookLogWriter::append(const Tse06Record& r) {
+    if (_finished) return;
+
+    BookState cur;
+    recordToState(r, cur);
+
+    if (_index.empty() || _sinceKey >= _keyEvery) {
+        writeKeyframe(cur.seq, cur.timeUs);
+    }
+
+    uint32_t idx;
+    auto it = _symIdx.find(r.stockId);
+    if (it == _symIdx.end()) {
+        idx = (uint32_t)_syms.size();
+        _symIdx.emplace(r.stockId, idx);
+        _syms.push_back(r.stockId);
+        _states.push_back(BookState{});
+
+        _buf.push_back(TAG_SYMDEF);
+        putVar(_buf, idx);
+        _buf.push_back((uint8_t)r.stockId.size());
+        _buf.insert(_buf.end(), r.stockId.begin(), r.stockId.end());
+    } else {
+        idx = it->second;
+    }
+
+    _buf.push_back(TAG_UPDATE);
+    putVar(_buf, idx);
+    putZig(_buf, (int64_t)cur.seq - (int64_t)_prevSeq);
+    encodeBody(_buf, _states[idx], cur);
+    emit();
+
+    _states[idx] = cur;
+    _prevSeq = cur.seq;
+    _sinceKey++;
+    _updates++;
+}
+
+void BookLogWriter::saveState(StateWriter& w) const {
+    w.put(_keyEvery);
+    w.put<uint64_t>(_syms.size());
+    for (const string& s : _syms) w.putString(s);
+    w.putVector(_states);
+    w.putVector(_index);
+    w.put(_prevSeq);
+    w.put(_sinceKey);
+    w.put(_updates);
+    w.put(_offset);
+}
+
+bool BookLogWriter::loadState(StateReader& r) {
+    uint32_t keyEvery = 0;
+    uint64_t n = 0;
+    if (!r.get(keyEvery) || keyEvery != _keyEvery || !r.get(n)) return false;
+    _syms.clear();
+    _symIdx.clear();
+    for (uint64_t i = 0; i < n && r.ok(); ++i) {
+        string s;
+        r.getString(s);
+        _symIdx.emplace(s, (uint32_t)_syms.size());
+        _syms.push_back(std::move(s));
+    }
+    r.getVector(_states);
+    r.getVector(_index);
+    r.get(_prevSeq);
+    r.get(_sinceKey);
+    r.get(_updates);
+    r.get(_offset);
+    return r.ok() && _states.size() == _syms.size();
+}
+
+void BookLogWriter::finish() {
+    if (_finished) return;
+    _finished = true;
+
+    uint64_t indexOff = _offset;
+    _buf.push_back(TAG_INDEX);
+    putVar(_buf, _index.size());
+    for (const auto& e : _index) {
+        putVar(_buf, e.offset);
+        putVar(_buf, e.seq);
+        putVar(_buf, (uint64_t)e.timeUs);
+    }
+    for (int i = 0; i < 8; ++i) _buf.push_back((uint8_t)(indexOff >> (8 * i)));
+    _buf.insert(_buf.end(), IDX_MAGIC, IDX_MAGIC + 8);
+    emit();
+}
+
+// ---- reader -----------------------------------------------------------------
+
+bool BookLogReader::open(const string& path) {
+    ifstream fin(path, ios::binary | ios::ate);
+    if (!fin) return false;
+    streamsize sz = fin.tellg();
+    if (sz < 8) return false;
+    fin.seekg(0);
+    _data.resize((size_t)sz);
+    if (!fin.read((char*)_data.data(), sz)) return false;
+    if (memcmp(_data.data(), LOG_MAGIC, 8) != 0) return false;
+
+    _pos = 8;
+    _end = _data.size();
+    _index.clear();
+    _syms.clear();
+    _states.clear();
+    _prevSeq = 0;
+    _corrupt = false;
+
+    // Trailer present -> load keyframe index
+    if (_data.size() >= 8 + 16 &&
+        memcmp(_data.data() + _data.size() - 8, IDX_MAGIC, 8) == 0) {
+        uint64_t off = 0;
+        for (int i = 0; i < 8; ++i) off |= (uint64_t)_data[_data.size() - 16 + i] << (8 * i);
+        size_t p = (size_t)off + 1;
+        size_t lim = _data.size() - 16;
+        uint64_t n;
+        if (off < _data.size() && _data[off] == TAG_INDEX && getVar(_data.data(), lim, p, n)) {
+            for (uint64_t i = 0; i < n; ++i) {
+                uint64_t o, s, t;
+                if (!getVar(_data.data(), lim, p, o) || !getVar(_data.data(), lim, p, s) ||
+                    !getVar(_data.data(), lim, p, t)) break;
+                _index.push_back(IndexEntry{o, (uint32_t)s, (int64_t)t});
+            }
+            _end = (size_t)off;
+        }
+    }
+    return true;
+}
+
+bool BookLogReader::next(const BookState*& st, const string*& sym) {
+    const uint8_t* d = _data.data();
+    while (_pos < _end) {
+        uint8_t tag = d[_pos++];
+        uint64_t idx, n;
+        int64_t dseq;
+
+        switch (tag) {
+        case TAG_UPDATE:
+            if (!getVar(d, _end, _pos, idx) || idx >= _states.size() ||
+                !getZig(d, _end, _pos, dseq)) { _corrupt = true; return false; }
+            {
+                BookState& s = _states[idx];
+                _prevSeq = (uint32_t)((int64_t)_prevSeq + dseq);
+                s.seq = _prevSeq;
+                if (!decodeBody(d, _end, _pos, s)) { _corrupt = true; return false; }
+                st = &s;
+                sym = &_syms[idx];
+            }
+            return true;
+
+        case TAG_SYMDEF:
+            if (!getVar(d, _end, _pos, idx) || idx != _syms.size() || _pos >= _end) {
+                _corrupt = true; return false;
+            }
+            n = d[_pos++];
+            if (_pos + n > _end) { _corrupt = true; return false; }
+            _syms.emplace_back((const char*)d + _pos, (size_t)n);
+            _states.push_back(BookState{});
+            _pos += n;
+            break;
+
+        case TAG_KEYFRAME: {
+            uint64_t prevSeq, count;
+            if (!getVar(d, _end, _pos, prevSeq) || !getVar(d, _end, _pos, count)) {
+                _corrupt = true; return false;
+            }
+            _prevSeq = (uint32_t)prevSeq;
+            _syms.clear();
+            _states.assign((size_t)count, BookState{});
+            for (uint64_t i = 0; i < count; ++i) {
+                if (_pos >= _end) { _corrupt = true; return false; }
+                n = d[_pos++];
+                if (_pos + n > _end) { _corrupt = true; return false; }
+                _syms.emplace_back((const char*)d + _pos, (size_t)n);
+                _pos += n;
+                uint64_t s;
+                if (!getVar(d, _end, _pos, s) || !decodeBody(d, _end, _pos, _states[i])) {
+                    _corrupt = true; return false;
+                }
+                _states[i].seq = (uint32_t)s;
+            }
+            break;
+        }
+
+        case TAG_INDEX:
+            return false;
+
+        default:
+            _corrupt = true;
+            return false;
+        }
+    }
+    return false;
+}
+
+bool BookLogReader::next(Tse06Record& r) {
+    const BookState* st;
+    const string* sym;
+    if (!next(st, sym)) return false;
+    stateToRecord(*st, *sym, r);
+    return true;
+}
+
+bool BookLogReader::seekKeyframe(size_t k) {
+    if (k >= _index.size()) return false;
+    _pos = (size_t)_index[k].offset;
+    _corrupt = false;
+    return _pos < _end && _data[_pos] == TAG_KEYFRAME;
+}
+
+bool BookLogReader::seekTime(int64_t timeUs) {
+    if (_index.empty()) return false;
+    size_t k = 0;
+    for (size_t i = 0; i < _index.size(); ++i) {
+        if (_index[i].timeUs <= timeUs) k = i;
+        else break;
+    }
+    return seekKeyframe(k);
+}
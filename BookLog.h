@@ -0,0 +1,136 @@
+#ifndef BOOK_LOG_H
+#define BOOK_LOG_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+#include "TseFmt06Parser.h"
+
+class AsyncSink;
+class StateWriter;
+class StateReader;
+
+// Compact binary archive of Format 06 updates.
+//
+// Every update is stored relative to the previous update of the same
+// symbol: a change mask, then zigzag varint deltas for the changed fields.
+// Prices are integer ticks of 0.0001 (the BCD 9(6)V9(4) units), times are
+// microseconds since midnight. A KEYFRAME carrying the symbol table and
+// the full state of every symbol is written every N updates, and an index
+// of keyframes is appended at close so a reader can start anywhere.
+//
+// File layout:
+//   "TSEBLOG1"
+//   records...      SYMDEF / UPDATE / KEYFRAME
+//   INDEX record
+//   trailer         u64 LE offset of INDEX + "TSEBIDX1"
+//
+// Decoded states are equivalent to Tse06Record except for the raw
+// checksum bytes; only checksumOK is kept.
+
+// Fixed-layout state of one symbol after an update
+struct BookState {
+    uint32_t seq{};
+    int64_t  timeUs{};          // matchTime, us since midnight
+    uint8_t  itemBitmap{};
+    uint8_t  limitBitmap{};
+    uint8_t  stateBitmap{};
+    uint32_t cumQty{};
+    int64_t  lastPx{};          // ticks (0.0001)
+    uint32_t lastQty{};
+    int64_t  bidPx[5]{};
+    uint32_t bidQty[5]{};
+    int64_t  askPx[5]{};
+    uint32_t askQty[5]{};
+    uint16_t msgLen{};
+    uint8_t  bizType{};         // BCD byte, e.g. 0x01
+    uint8_t  fmtVer{};
+    bool     checksumOK{true};
+};
+
+// Conversions shared by writer, reader and other binary outputs
+int64_t pxToTicks(double px);
+double  ticksToPx(int64_t ticks);
+int64_t matchTimeToUs(const std::string& hhmmss);   // "HH:MM:SS.mmmuuu"
+std::string usToMatchTime(int64_t us);
+void recordToState(const Tse06Record& r, BookState& st);
+void stateToRecord(const BookState& st, const std::string& stockId, Tse06Record& r);
+
+class BookLogWriter {
+public:
+    // out must stay open until close(). keyframeEvery: updates between keyframes
+    // resumed: out already holds the log up to a checkpoint; loadState()
+    // must follow before the first append()
+    explicit BookLogWriter(AsyncSink* out, uint32_t keyframeEvery = 65536,
+                           bool resumed = false);
+
+    void append(const Tse06Record& r);
+
+    // Checkpoint: symbol table, per-symbol states, keyframe index, offset
+    void saveState(StateWriter& w) const;
+    bool loadState(StateReader& r);
+
+    // Write the keyframe index and trailer (does not close the sink)
+    void finish();
+
+    uint64_t updates()   const { return _updates; }
+    uint64_t bytes()     const { return _offset; }
+    uint64_t keyframes() const { return _index.size(); }
+
+private:
+    struct IndexEntry { uint64_t offset; uint32_t seq; int64_t timeUs; };
+
+    void writeKeyframe(uint32_t seq, int64_t timeUs);
+    void emit();
+
+    AsyncSink*                      _out;
+    uint32_t                        _keyEvery;
+    std::vector<uint8_t>            _buf;      // one encoded record
+    std::unordered_map<std::string, uint32_t> _symIdx;
+    std::vector<std::string>        _syms;
+    std::vector<BookState>          _states;
+    std::vector<IndexEntry>         _index;
+    uint32_t                        _prevSeq = 0;
+    uint32_t                        _sinceKey = 0;
+    uint64_t                        _updates = 0;
+    uint64_t                        _offset = 0;
+    bool                            _finished = false;
+};
+
+class BookLogReader {
+public:
+    // Loads the file into memory. Returns false if it is not a book log.
+    bool open(const std::string& path);
+
+    // Fast path: decode the next update, st/sym point into reader state
+    // and stay valid until the next call. Returns false at end of log.
+    bool next(const BookState*& st, const std::string*& sym);
+
+    // Convenience: next update as a full Tse06Record
+    bool next(Tse06Record& r);
+
+    size_t keyframeCount() const { return _index.size(); }
+    // Position the reader at keyframe k (states restored from it)
+    bool seekKeyframe(size_t k);
+    // Position at the last keyframe whose first update time <= timeUs
+    bool seekTime(int64_t timeUs);
+
+    bool corrupt() const { return _corrupt; }
+    size_t sizeBytes() const { return _data.size(); }
+
+private:
+    struct IndexEntry { uint64_t offset; uint32_t seq; int64_t timeUs; };
+
+    std::vector<uint8_t>     _data;
+    size_t                   _pos = 0;
+    size_t                   _end = 0;   // start of INDEX record
+    std::vector<IndexEntry>  _index;
+    std::vector<std::string> _syms;
+    std::vector<BookState>   _states;
+    uint32_t                 _prevSeq = 0;
+    bool                     _corrupt = false;
+};
+
+#endif // BOOK_LOG_H
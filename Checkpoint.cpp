@@ -0,0 +1,138 @@
+#include "Checkpoint.h"
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <fcntl.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+static const char CKPT_MAGIC[8] = {'T', 'S', 'E', 'C', 'K', 'P', 'T', '1'};
+
+void Checkpoint::setSection(const string& name, string state) {
+    for (auto& s : sections) {
+        if (s.first == name) { s.second = std::move(state); return; }
+    }
+    sections.emplace_back(name, std::move(state));
+}
+
+const string* Checkpoint::section(const string& name) const {
+    for (const auto& s : sections) {
+        if (s.first == name) return &s.second;
+    }
+    return nullptr;
+}
+
+uint64_t Checkpoint::outputSize(const string& path, bool& found) const {
+    for (const auto& o : outputs) {
+        if (o.first == path) { found = true; return o.second; }
+    }
+    found = false;
+    return 0;
+}
+
+// Write, flush to disk and close
+static bool writeDurable(const string& path, const string& data) {
+#ifdef _WIN32
+    int fd = _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, 0644);
+#else
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+    if (fd < 0) return false;
+    size_t done = 0;
+    bool ok = true;
+    while (done < data.size()) {
+#ifdef _WIN32
+        int w = _write(fd, data.data() + done, (unsigned)(data.size() - done));
+#else
+        long w = (long)::write(fd, data.data() + done, data.size() - done);
+#endif
+        if (w <= 0) { ok = false; break; }
+        done += (size_t)w;
+    }
+#ifdef _WIN32
+    ok = ok && _commit(fd) == 0;
+    _close(fd);
+#else
+    ok = ok && ::fsync(fd) == 0;
+    ::close(fd);
+#endif
+    return ok;
+}
+
+size_t Checkpoint::save(const string& path) const {
+    string blob(CKPT_MAGIC, sizeof(CKPT_MAGIC));
+    StateWriter w(blob);
+    w.putString(input);
+    w.put(inputOffset);
+    w.put(framerOffset);
+    w.putString(framerBytes);
+    w.put<uint64_t>(outputs.size());
+    for (const auto& o : outputs) {
+        w.putString(o.first);
+        w.put(o.second);
+    }
+    w.put<uint64_t>(sections.size());
+    for (const auto& s : sections) {
+        w.putString(s.first);
+        w.putString(s.second);
+    }
+
+    string tmp = path + ".tmp";
+    if (!writeDurable(tmp, blob)) {
+        cerr << "[ERROR] checkpoint " << tmp << " cannot write.\n";
+        return 0;
+    }
+#ifdef _WIN32
+    bool renamed = MoveFileExA(tmp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    bool renamed = ::rename(tmp.c_str(), path.c_str()) == 0;
+#endif
+    if (!renamed) {
+        cerr << "[ERROR] checkpoint " << path << " cannot replace.\n";
+        return 0;
+    }
+    return blob.size();
+}
+
+bool Checkpoint::load(const string& path) {
+    ifstream fin(path, ios::binary);
+    if (!fin) return false;
+    string blob((istreambuf_iterator<char>(fin)), istreambuf_iterator<char>());
+    if (blob.size() < sizeof(CKPT_MAGIC) || memcmp(blob.data(), CKPT_MAGIC, sizeof(CKPT_MAGIC)) != 0) {
+        return false;
+    }
+    string body = blob.substr(sizeof(CKPT_MAGIC));
+    StateReader r(body);
+
+    uint64_t n = 0;
+    r.getString(input);
+    r.get(inputOffset);
+    r.get(framerOffset);
+    r.getString(framerBytes);
+    outputs.clear();
+    if (r.get(n)) {
+        for (uint64_t i = 0; i < n && r.ok(); ++i) {
+            pair<string, uint64_t> o;
+            r.getString(o.first);
+            r.get(o.second);
+            outputs.push_back(o);
+        }
+    }
+    sections.clear();
+    if (r.get(n)) {
+        for (uint64_t i = 0; i < n && r.ok(); ++i) {
+            pair<string, string> s;
+            r.getString(s.first);
+            r.getString(s.second);
+            sections.push_back(std::move(s));
+        }
+    }
+    return r.done();
+}
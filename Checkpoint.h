@@ -0,0 +1,110 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <type_traits>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+// Checkpoint / resume for long single-file runs (main --checkpoint-mb,
+// --resume).
+//
+// A checkpoint is taken between two framer feeds. It records the input
+// stream offset, the bytes StreamFramer still holds (a partial message),
+// the durable size of every output, the row counters, and one state blob
+// per stateful engine (book log writer, bar aggregator). --resume
+// truncates the outputs to those sizes, skips the input to the offset,
+// and restores everything else, so the finished outputs are byte-identical
+// to an uninterrupted run.
+//
+// The file is written to PATH.tmp, fsynced and renamed over PATH, so a
+// crash while checkpointing leaves the previous checkpoint intact.
+// Encoding is host byte order: a checkpoint is read back by the same
+// build on the same machine.
+
+// Append-only encoder for state blobs
+class StateWriter {
+public:
+    explicit StateWriter(std::string& out) : _out(out) {}
+
+    template <class T>
+    void put(const T& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "POD only");
+        _out.append(reinterpret_cast<const char*>(&v), sizeof(T));
+    }
+    void putString(const std::string& s) {
+        put<uint64_t>(s.size());
+        _out.append(s);
+    }
+    template <class T>
+    void putVector(const std::vector<T>& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "POD only");
+        put<uint64_t>(v.size());
+        if (!v.empty()) _out.append(reinterpret_cast<const char*>(v.data()), v.size() * sizeof(T));
+    }
+
+private:
+    std::string& _out;
+};
+
+// Matching decoder; ok() turns false on any short read and stays false
+class StateReader {
+public:
+    explicit StateReader(const std::string& in) : _in(in) {}
+
+    template <class T>
+    bool get(T& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "POD only");
+        if (!_ok || _in.size() - _pos < sizeof(T)) return _ok = false;
+        memcpy(&v, _in.data() + _pos, sizeof(T));
+        _pos += sizeof(T);
+        return true;
+    }
+    bool getString(std::string& s) {
+        uint64_t n = 0;
+        if (!get(n) || _in.size() - _pos < n) return _ok = false;
+        s.assign(_in.data() + _pos, (size_t)n);
+        _pos += (size_t)n;
+        return true;
+    }
+    template <class T>
+    bool getVector(std::vector<T>& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "POD only");
+        uint64_t n = 0;
+        if (!get(n) || (_in.size() - _pos) / sizeof(T) < n) return _ok = false;
+        v.resize((size_t)n);
+        if (n) memcpy(v.data(), _in.data() + _pos, (size_t)n * sizeof(T));
+        _pos += (size_t)n * sizeof(T);
+        return true;
+    }
+
+    bool ok() const { return _ok; }
+    bool done() const { return _ok && _pos == _in.size(); }
+
+private:
+    const std::string& _in;
+    size_t _pos = 0;
+    bool   _ok = true;
+};
+
+struct Checkpoint {
+    std::string input;                 // input path
+    uint64_t    inputOffset = 0;       // stream bytes consumed (decompressed)
+    uint64_t    framerOffset = 0;      // stream offset of framerBytes[0]
+    std::string framerBytes;           // partial message held by StreamFramer
+    std::vector<std::pair<std::string, uint64_t>> outputs;     // path, durable size
+    std::vector<std::pair<std::string, std::string>> sections; // engine name, state
+
+    void setSection(const std::string& name, std::string state);
+    const std::string* section(const std::string& name) const;
+    uint64_t outputSize(const std::string& path, bool& found) const;
+
+    // Atomic replace (PATH.tmp + fsync + rename). Returns bytes written, 0 on failure.
+    size_t save(const std::string& path) const;
+    bool   load(const std::string& path);
+};
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,244 @@
+#include "FollowSource.h"
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <poll.h>
+#endif
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+using namespace std;
+
+static const int WAIT_SLICE_MS = 100;   // longest blind sleep (stop / idle checks)
+
+static uint64_t nowNs() {
+    return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#ifdef _WIN32
+static long sysRead(int fd, uint8_t* dst, size_t cap) { return _read(fd, dst, (unsigned)cap); }
+static int  sysClose(int fd) { return _close(fd); }
+static int  sysOpen(const char* p) { return _open(p, _O_RDONLY | _O_BINARY); }
+static int  sysSeek0(int fd) { return _lseeki64(fd, 0, SEEK_SET) < 0 ? -1 : 0; }
+static bool sysSeekTo(int fd, uint64_t off) { return _lseeki64(fd, (long long)off, SEEK_SET) >= 0; }
+static bool fileSize(int fd, uint64_t& size) {
+    struct _stat64 st;
+    if (_fstat64(fd, &st) != 0) return false;
+    size = (uint64_t)st.st_size;
+    return true;
+}
+static bool fileId(int, uint64_t& dev, uint64_t& ino) { dev = ino = 0; return true; }
+#else
+static long sysRead(int fd, uint8_t* dst, size_t cap) { return (long)::read(fd, dst, cap); }
+static int  sysClose(int fd) { return ::close(fd); }
+static int  sysOpen(const char* p) { return ::open(p, O_RDONLY | O_CLOEXEC); }
+static int  sysSeek0(int fd) { return lseek(fd, 0, SEEK_SET) < 0 ? -1 : 0; }
+static bool sysSeekTo(int fd, uint64_t off) { return lseek(fd, (off_t)off, SEEK_SET) >= 0; }
+static bool fileSize(int fd, uint64_t& size) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) return false;
+    size = (uint64_t)st.st_size;
+    return true;
+}
+static bool fileId(int fd, uint64_t& dev, uint64_t& ino) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) return false;
+    dev = (uint64_t)st.st_dev;
+    ino = (uint64_t)st.st_ino;
+    return true;
+}
+#endif
+
+FollowSource::FollowSource(const string& path, const FollowOptions& opt)
+    : _path(path), _opt(opt) {
+    _m.codec = "follow";
+    if (_opt.maxPollMs < 1) _opt.maxPollMs = 1;
+}
+
+FollowSource::~FollowSource() {
+    closeFile();
+#ifdef __linux__
+    if (_ifd >= 0) ::close(_ifd);
+#endif
+}
+
+unique_ptr<FollowSource> FollowSource::open(const string& path, const FollowOptions& opt) {
+    unique_ptr<FollowSource> src(new FollowSource(path, opt));
+#ifdef __linux__
+    // Directory watch catches the replacement file after a rotation
+    src->_ifd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (src->_ifd >= 0) {
+        string dir = ".";
+        size_t slash = path.find_last_of('/');
+        if (slash != string::npos) dir = slash == 0 ? "/" : path.substr(0, slash);
+        src->_dirWd = inotify_add_watch(src->_ifd, dir.c_str(), IN_CREATE | IN_MOVED_TO);
+    }
+#endif
+    if (!src->openFile()) return nullptr;
+    if (src->_fileWd >= 0) src->_fm.waiter = "inotify";
+
+    // Archives are rejected: only a raw capture grows in place
+    uint8_t magic[4] = {};
+    long n = sysRead(src->_fd, magic, sizeof(magic));
+    bool gz  = n >= 2 && magic[0] == 0x1F && magic[1] == 0x8B;
+    bool zst = n >= 4 && magic[0] == 0x28 && magic[1] == 0xB5 && magic[2] == 0x2F && magic[3] == 0xFD;
+    if (gz || zst || sysSeek0(src->_fd) != 0) {
+        cerr << "[ERROR] --follow needs a raw capture: " << path << "\n";
+        return nullptr;
+    }
+
+    src->_lastDataNs = nowNs();
+    return src;
+}
+
+bool FollowSource::openFile() {
+    _fd = sysOpen(_path.c_str());
+    _offset = 0;
+#ifdef __linux__
+    if (_fd >= 0 && _ifd >= 0) {
+        if (_fileWd >= 0) inotify_rm_watch(_ifd, _fileWd);
+        _fileWd = inotify_add_watch(_ifd, _path.c_str(),
+                                    IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF);
+    }
+#endif
+    return _fd >= 0;
+}
+
+void FollowSource::closeFile() {
+    if (_fd >= 0) sysClose(_fd);
+    _fd = -1;
+}
+
+// Called at EOF: true if reading should restart from another file / offset 0
+bool FollowSource::checkReplaced() {
+    uint64_t size = 0;
+    if (fileSize(_fd, size) && size < _offset) {
+        if (sysSeek0(_fd) != 0) return false;
+        _offset = 0;
+        _generation++;
+        _fm.truncations++;
+        return true;
+    }
+
+#ifndef _WIN32
+    // Rotation: the path now names a different inode (old one is drained)
+    struct stat cur, onDisk;
+    if (fstat(_fd, &cur) != 0 || stat(_path.c_str(), &onDisk) != 0) return false;
+    if (cur.st_ino == onDisk.st_ino && cur.st_dev == onDisk.st_dev) return false;
+
+    closeFile();
+    openFile();             // read() retries if the new file vanished again
+    _generation++;
+    _fm.rotations++;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void FollowSource::wait() {
+    uint64_t t0 = nowNs();
+#ifdef __linux__
+    if (_ifd >= 0 && _fileWd >= 0) {
+        struct pollfd pfd = {_ifd, POLLIN, 0};
+        int rc = poll(&pfd, 1, WAIT_SLICE_MS);
+        if (rc > 0) {
+            alignas(struct inotify_event) char buf[4096];
+            long n;
+            while ((n = ::read(_ifd, buf, sizeof(buf))) > 0) {
+                for (char* p = buf; p < buf + n; ) {
+                    const struct inotify_event* ev = reinterpret_cast<const struct inotify_event*>(p);
+                    _fm.notifyEvents++;
+                    p += sizeof(struct inotify_event) + ev->len;
+                }
+            }
+        }
+        _fm.wakeups++;
+        uint64_t us = (nowNs() - t0) / 1000;
+        if (us > _fm.maxWaitUs) _fm.maxWaitUs = us;
+        return;
+    }
+#endif
+    // Adaptive poll: short sleeps while data keeps coming, longer when quiet
+    this_thread::sleep_for(chrono::microseconds(_pollUs));
+    _pollUs = min<uint32_t>(_pollUs * 2, (uint32_t)_opt.maxPollMs * 1000);
+    _fm.wakeups++;
+    uint64_t us = (nowNs() - t0) / 1000;
+    if (us > _fm.maxWaitUs) _fm.maxWaitUs = us;
+}
+
+bool FollowSource::skip(uint64_t n) {
+    uint64_t size = 0;
+    if (_fd < 0 || !fileSize(_fd, size) || size < _offset + n) return false;
+    if (!sysSeekTo(_fd, _offset + n)) return false;
+    _offset += n;
+    _m.compressedBytes += n;
+    _m.outputBytes += n;
+    return true;
+}
+
+FollowSource::Position FollowSource::position() const {
+    Position p;
+    p.offset = _offset;
+    if (_fd >= 0) fileId(_fd, p.dev, p.ino);
+    return p;
+}
+
+bool FollowSource::resumeAt(const Position& pos, uint64_t streamBytes) {
+    uint64_t dev = 0, ino = 0, size = 0;
+    if (_fd < 0 || !fileId(_fd, dev, ino) || dev != pos.dev || ino != pos.ino) return false;
+    if (!fileSize(_fd, size) || size < pos.offset || !sysSeekTo(_fd, pos.offset)) return false;
+    _offset = pos.offset;
+    _m.compressedBytes = streamBytes;
+    _m.outputBytes = streamBytes;
+    return true;
+}
+
+long FollowSource::read(uint8_t* dst, size_t cap) {
+    while (!_stop.load(memory_order_relaxed)) {
+        if (_fd < 0 && !openFile()) {
+            wait();
+            continue;
+        }
+        long n = sysRead(_fd, dst, cap);
+        if (n > 0) {
+            _offset += (uint64_t)n;
+            _m.compressedBytes += (uint64_t)n;
+            _m.outputBytes += (uint64_t)n;
+            _lastDataNs = nowNs();
+            _pollUs = 100;
+            _idleNotified = false;
+            return n;
+        }
+        if (n < 0 && errno != EINTR) return -1;
+        if (n < 0) continue;
+
+        // At EOF
+        if (checkReplaced()) continue;
+
+        uint64_t idleNs = nowNs() - _lastDataNs;
+        if (idleNs < (uint64_t)_opt.spinUs * 1000) {
+            this_thread::yield();
+            continue;
+        }
+        if (!_idleNotified) {
+            _idleNotified = true;
+            if (onIdle) onIdle();
+            continue;
+        }
+        if (_opt.idleExitSec > 0 && idleNs >= (uint64_t)_opt.idleExitSec * 1000000000ull) return 0;
+        wait();
+    }
+    return 0;
+}
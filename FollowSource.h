@@ -0,0 +1,110 @@
+#ifndef FOLLOW_SOURCE_H
+#define FOLLOW_SOURCE_H
+
+#include <string>
+#include <memory>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+
+#include "InputSource.h"
+
+// Tail-follow a raw capture that is still being appended (main --follow).
+//
+// read() returns whatever bytes are available and otherwise blocks until
+// the writer appends more; the caller keeps feeding StreamFramer, which
+// holds a partial message until its remaining bytes arrive.
+//
+// Waiting: right after data the file is re-checked with a short spin
+// (bursts arrive together), then onIdle runs once (main flushes its
+// outputs there), then the reader sleeps on inotify (Linux) or on an
+// adaptive poll whose interval doubles from 100us up to maxPollMs.
+//
+// Rotation (path now names another file) is noticed once the old file is
+// drained; the new file is then read from its start. Truncation (size
+// below the read offset) restarts at 0. Both bump generation(): bytes the
+// framer holds from before belong to another file and must be dropped.
+
+struct FollowOptions {
+    int idleExitSec = 0;    // return EOF after this long without new bytes (0: never)
+    int spinUs      = 200;  // re-check window after data, before sleeping
+    int maxPollMs   = 10;   // poll fallback ceiling
+};
+
+struct FollowMetrics {
+    const char* waiter = "poll";   // "inotify" or "poll"
+    uint64_t wakeups{};            // sleeps that ended
+    uint64_t notifyEvents{};       // inotify events read
+    uint64_t rotations{};
+    uint64_t truncations{};
+    uint64_t maxWaitUs{};          // longest single sleep before data
+};
+
+class FollowSource : public InputSource {
+public:
+    ~FollowSource() override;
+
+    // Raw captures only (an archive cannot be appended to)
+    static std::unique_ptr<FollowSource> open(const std::string& path, const FollowOptions& opt);
+
+    // Bytes read; blocks while the file has nothing new.
+    // 0: stop() was called or the idle timeout expired. -1: error.
+    long read(uint8_t* dst, size_t cap) override;
+
+    // Seek forward in the current file
+    bool skip(uint64_t n) override;
+
+    // Checkpoint position: offset in the file being read and that file's
+    // identity (device / inode, 0 on Windows). The stream offset
+    // (metrics().outputBytes) runs on across rotations and truncations,
+    // so it cannot be used to seek.
+    struct Position {
+        uint64_t offset = 0;
+        uint64_t dev = 0;
+        uint64_t ino = 0;
+    };
+    Position position() const;
+
+    // Resume: continue at pos if the path still names the same file and
+    // it is at least that long. streamBytes restores metrics().outputBytes.
+    bool resumeAt(const Position& pos, uint64_t streamBytes);
+
+    // Make a blocked read() return 0 (async-signal-safe)
+    void stop() { _stop.store(true, std::memory_order_relaxed); }
+
+    // Changes on every rotation / truncation
+    uint64_t generation() const { return _generation; }
+
+    const FollowMetrics& followMetrics() const { return _fm; }
+
+    // Runs once each time the reader has caught up, before it sleeps
+    std::function<void()> onIdle;
+
+private:
+    FollowSource(const std::string& path, const FollowOptions& opt);
+
+    bool openFile();
+    void closeFile();
+    bool checkReplaced();   // at EOF: rotation / truncation
+    void wait();            // sleep until the file may have changed
+
+    std::string   _path;
+    FollowOptions _opt;
+    int      _fd = -1;
+    uint64_t _offset = 0;
+    uint64_t _generation = 0;
+    uint64_t _lastDataNs = 0;
+    uint32_t _pollUs = 100;
+    bool     _idleNotified = false;
+    std::atomic<bool> _stop{false};
+
+    // inotify (Linux)
+    int _ifd = -1;
+    int _fileWd = -1;
+    int _dirWd = -1;
+
+    FollowMetrics _fm;
+};
+
+#endif // FOLLOW_SOURCE_H
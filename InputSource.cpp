@@ -0,0 +1,365 @@
+#include "InputSource.h"
+#include "WorkStealingPool.h"
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+#include <zlib.h>
+
+#ifdef TSE_WITH_ZSTD
+#include <zstd.h>
+#include <zstd_errors.h>
+#endif
+
+using namespace std;
+
+static const size_t IN_CHUNK = 1024 * 1024; // compressed read size
+
+static uint64_t nowNs() {
+    return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool InputSource::skip(uint64_t n) {
+    vector<uint8_t> sink(64 * 1024);
+    while (n > 0) {
+        long got = read(sink.data(), (size_t)min<uint64_t>(n, sink.size()));
+        if (got <= 0) return false;
+        n -= (uint64_t)got;
+    }
+    return true;
+}
+
+// ---- raw capture ------------------------------------------------------------
+
+class RawSource : public InputSource {
+    ifstream _fin;
+public:
+    explicit RawSource(const string& path) : _fin(path, ios::binary) {
+        _m.codec = "raw";
+    }
+    bool ok() const { return (bool)_fin; }
+
+    long read(uint8_t* dst, size_t cap) override {
+        _fin.read((char*)dst, (streamsize)cap);
+        long got = (long)_fin.gcount();
+        _m.compressedBytes += got;
+        _m.outputBytes += got;
+        return got;
+    }
+
+    bool skip(uint64_t n) override {
+        streampos cur = _fin.tellg();
+        _fin.seekg(0, ios::end);
+        if (!_fin || (uint64_t)(_fin.tellg() - cur) < n) return false;
+        _fin.seekg(cur + (streamoff)n);
+        _m.compressedBytes += n;
+        _m.outputBytes += n;
+        return true;
+    }
+};
+
+// ---- gzip (zlib, multi-member) ---------------------------------------------
+
+class GzipSource : public InputSource {
+    ifstream        _fin;
+    vector<uint8_t> _in;
+    z_stream        _zs{};
+    bool            _init = false;
+    bool            _eof = false;
+    bool            _inMember = false;  // a member is started but not finished
+public:
+    explicit GzipSource(const string& path) : _fin(path, ios::binary), _in(IN_CHUNK) {
+        _m.codec = "gzip";
+        // 15 + 32: auto-detect gzip / zlib header
+        _init = (inflateInit2(&_zs, 15 + 32) == Z_OK);
+        _m.frames = 1;
+    }
+    ~GzipSource() override {
+        if (_init) inflateEnd(&_zs);
+    }
+    bool ok() const { return _init && (bool)_fin; }
+
+    long read(uint8_t* dst, size_t cap) override {
+        _zs.next_out  = dst;
+        _zs.avail_out = (uInt)cap;
+
+        uint64_t t0 = nowNs();
+        while (_zs.avail_out > 0) {
+            if (_zs.avail_in == 0) {
+                if (_eof) break;
+                _fin.read((char*)_in.data(), (streamsize)_in.size());
+                streamsize got = _fin.gcount();
+                if (got <= 0) {
+                    _eof = true;
+                    if (_inMember) {
+                        // A short read would look like a clean end to the caller
+                        cerr << "[ERROR] truncated gzip member at EOF\n";
+                        return -1;
+                    }
+                    break;
+                }
+                _m.compressedBytes += got;
+                _zs.next_in  = _in.data();
+                _zs.avail_in = (uInt)got;
+            }
+
+            int rc = inflate(&_zs, Z_NO_FLUSH);
+            _inMember = (rc != Z_STREAM_END);
+            if (rc == Z_STREAM_END) {
+                // Concatenated gzip members (e.g. cat a.gz b.gz)
+                if (_zs.avail_in == 0 && _fin.peek() == EOF) { _eof = true; break; }
+                inflateReset(&_zs);
+                _m.frames++;
+            } else if (rc != Z_OK && rc != Z_BUF_ERROR) {
+                cerr << "[ERROR] gzip decode failed: " << (_zs.msg ? _zs.msg : "?") << "\n";
+                return -1;
+            }
+        }
+        _m.decodeNs += nowNs() - t0;
+
+        long got = (long)(cap - _zs.avail_out);
+        _m.outputBytes += got;
+        return got;
+    }
+};
+
+// ---- zstd (streamed; independent frames decoded in parallel) ---------------
+
+#ifdef TSE_WITH_ZSTD
+// Parallel path limits: a frame must fit the compressed window and decode
+// into a bounded slot buffer, anything larger is streamed
+static const size_t ZSTD_MAX_WINDOW    = 16 * 1024 * 1024;
+static const size_t ZSTD_MAX_FRAME_OUT = 16 * 1024 * 1024;
+
+class ZstdSource : public InputSource {
+    struct Slot {
+        vector<uint8_t> out;   // reused across batches
+        size_t          size = 0;
+        size_t          need = 0;
+        bool            failed = false;
+        ZSTD_DCtx*      dctx = nullptr;
+        const uint8_t*  src = nullptr;
+        size_t          srcLen = 0;
+    };
+
+    ifstream        _fin;
+    int             _threads;
+    ZSTD_DCtx*      _dctx = nullptr;  // streaming decoder
+    vector<uint8_t> _in;              // compressed window
+    size_t          _inBeg = 0, _inEnd = 0;
+    bool            _eof = false;
+    bool            _started = false;
+    bool            _inFrame = false; // streaming: frame not finished yet
+    bool            _failed = false;
+
+    // Parallel path, taken only for files of several frames
+    bool            _parallel = false;
+    unique_ptr<WorkStealingPool> _pool;
+    vector<Slot>    _slots;
+    int             _ready = 0;       // slots filled by the last batch
+    int             _slotIdx = 0;
+    size_t          _slotPos = 0;
+
+    // Top up the window; grow = allow doubling (parallel path, capped)
+    bool refill(bool grow) {
+        if (_eof) return false;
+        if (_inBeg > 0) {
+            memmove(_in.data(), _in.data() + _inBeg, _inEnd - _inBeg);
+            _inEnd -= _inBeg;
+            _inBeg = 0;
+        }
+        if (_inEnd == _in.size()) {
+            if (!grow || _in.size() >= ZSTD_MAX_WINDOW) return false;
+            _in.resize(min(_in.size() * 2, ZSTD_MAX_WINDOW));
+        }
+        _fin.read((char*)_in.data() + _inEnd, (streamsize)(_in.size() - _inEnd));
+        streamsize got = _fin.gcount();
+        if (got <= 0) { _eof = true; return false; }
+        _m.compressedBytes += got;
+        _inEnd += (size_t)got;
+        return true;
+    }
+
+    // First read: parallel only if the first frame is complete inside the
+    // initial window and more data follows (a multi-frame file)
+    void start() {
+        _started = true;
+        if (_threads < 2) return;
+        _in.resize(IN_CHUNK * 4);
+        while (refill(false)) {}
+        size_t fsz = ZSTD_findFrameCompressedSize(_in.data(), _inEnd);
+        if (ZSTD_isError(fsz) || (fsz == _inEnd && _eof)) return;
+
+        _parallel = true;
+        _pool.reset(new WorkStealingPool(_threads - 1));
+        _slots.resize(_threads);
+        for (auto& s : _slots) s.dctx = ZSTD_createDCtx();
+    }
+
+    static void decodeFrame(Slot& s) {
+        size_t rc = ZSTD_decompressDCtx(s.dctx, s.out.data(), s.need, s.src, s.srcLen);
+        s.failed = ZSTD_isError(rc);
+        s.size = s.failed ? 0 : rc;
+    }
+
+    // Cut up to N complete frames from the window and decode them on the
+    // pool. Leaves the parallel path (for good) at a frame it cannot take:
+    // unknown or oversized content, larger than the window, or not a valid
+    // frame; the streaming decoder continues from there and reports errors.
+    bool nextBatch() {
+        _ready = 0;
+        _slotIdx = 0;
+        _slotPos = 0;
+        while (_ready < (int)_slots.size()) {
+            size_t avail = _inEnd - _inBeg;
+            if (avail == 0) {
+                if (_ready > 0 || !refill(true)) break;
+                continue;
+            }
+            const uint8_t* p = _in.data() + _inBeg;
+            size_t fsz = ZSTD_findFrameCompressedSize(p, avail);
+            if (ZSTD_isError(fsz)) {
+                if (ZSTD_getErrorCode(fsz) != ZSTD_error_srcSize_wrong) { _parallel = false; break; }
+                if (_ready > 0) break;          // decode what we have first
+                if (!refill(true)) { _parallel = false; break; }
+                continue;
+            }
+            unsigned long long need = ZSTD_getFrameContentSize(p, fsz);
+            if (need == ZSTD_CONTENTSIZE_UNKNOWN || need == ZSTD_CONTENTSIZE_ERROR ||
+                need > ZSTD_MAX_FRAME_OUT) {
+                _parallel = false;
+                break;
+            }
+            Slot& s = _slots[_ready++];
+            s.src = p;
+            s.srcLen = fsz;
+            s.need = (size_t)need;
+            if (s.out.size() < s.need) s.out.resize(s.need);
+            _inBeg += fsz;
+        }
+        if (_ready == 0) return false;
+
+        uint64_t t0 = nowNs();
+        for (int i = 1; i < _ready; ++i) {
+            Slot* s = &_slots[i];
+            _pool->submit([s] { decodeFrame(*s); });
+        }
+        decodeFrame(_slots[0]);
+        _pool->wait();
+        _m.decodeNs += nowNs() - t0;
+        _m.frames += _ready;
+
+        for (int i = 0; i < _ready; ++i) {
+            if (_slots[i].failed) {
+                cerr << "[ERROR] zstd decode failed in frame " << (_m.frames - _ready + i) << "\n";
+                _failed = true;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Streaming decode with fixed ZSTD_DStreamInSize / OutSize buffers
+    long streamRead(uint8_t* dst, size_t cap) {
+        uint64_t t0 = nowNs();
+        ZSTD_outBuffer out{dst, cap, 0};
+        while (out.pos < out.size) {
+            if (_inBeg == _inEnd && !refill(false)) {
+                if (_inFrame) {
+                    cerr << "[ERROR] truncated zstd frame at EOF\n";
+                    return -1;
+                }
+                break;
+            }
+            ZSTD_inBuffer in{_in.data() + _inBeg, _inEnd - _inBeg, 0};
+            size_t rc = ZSTD_decompressStream(_dctx, &out, &in);
+            _inBeg += in.pos;
+            if (ZSTD_isError(rc)) {
+                cerr << "[ERROR] zstd decode failed in frame " << _m.frames << ": "
+                     << ZSTD_getErrorName(rc) << "\n";
+                return -1;
+            }
+            _inFrame = rc != 0;
+            if (rc == 0) _m.frames++;
+        }
+        _m.decodeNs += nowNs() - t0;
+        return (long)out.pos;
+    }
+
+public:
+    ZstdSource(const string& path, int threads)
+        : _fin(path, ios::binary), _threads(threads), _in(ZSTD_DStreamInSize()) {
+        _m.codec = "zstd";
+        _dctx = ZSTD_createDCtx();
+    }
+    ~ZstdSource() override {
+        _pool.reset();
+        for (auto& s : _slots) ZSTD_freeDCtx(s.dctx);
+        ZSTD_freeDCtx(_dctx);
+    }
+    bool ok() const { return (bool)_fin && _dctx; }
+
+    long read(uint8_t* dst, size_t cap) override {
+        if (!_started) start();
+        size_t done = 0;
+        while (done < cap && !_failed) {
+            if (_slotIdx < _ready) {
+                Slot& s = _slots[_slotIdx];
+                size_t take = min(cap - done, s.size - _slotPos);
+                memcpy(dst + done, s.out.data() + _slotPos, take);
+                done += take;
+                _slotPos += take;
+                if (_slotPos == s.size) { _slotIdx++; _slotPos = 0; }
+                continue;
+            }
+            // Slots point into _in, so a new batch is cut only when all are consumed
+            if (_parallel) {
+                if (nextBatch()) continue;
+                if (_failed || _parallel) break;    // error or end of input
+            }
+            long got = streamRead(dst + done, cap - done);
+            if (got < 0) { _failed = true; break; }
+            if (got == 0) break;
+            done += (size_t)got;
+        }
+        if (_failed) return -1;         // a short read would look like EOF
+        _m.outputBytes += done;
+        return (long)done;
+    }
+};
+#endif
+
+// ---- factory ----------------------------------------------------------------
+
+unique_ptr<InputSource> InputSource::open(const string& path, int threads) {
+    uint8_t magic[4] = {0, 0, 0, 0};
+    {
+        ifstream probe(path, ios::binary);
+        if (!probe) return nullptr;
+        probe.read((char*)magic, 4);
+    }
+
+    if (magic[0] == 0x1F && magic[1] == 0x8B) {
+        unique_ptr<GzipSource> src(new GzipSource(path));
+        if (!src->ok()) return nullptr;
+        return src;
+    }
+
+    if (magic[0] == 0x28 && magic[1] == 0xB5 && magic[2] == 0x2F && magic[3] == 0xFD) {
+#ifdef TSE_WITH_ZSTD
+        unique_ptr<ZstdSource> src(new ZstdSource(path, threads));
+        if (!src->ok()) return nullptr;
+        return src;
+#else
+        (void)threads;
+        cerr << "[ERROR] " << path << " is zstd, rebuild with TSE_WITH_ZSTD\n";
+        return nullptr;
+#endif
+    }
+
+    unique_ptr<RawSource> src(new RawSource(path));
+    if (!src->ok()) return nullptr;
+    return src;
+}
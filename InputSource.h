@@ -0,0 +1,47 @@
+#ifndef INPUT_SOURCE_H
+#define INPUT_SOURCE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+// Byte stream feeding StreamFramer. Raw captures are read as-is, gzip and
+// zstd archives are decompressed on the fly into reusable buffers so no
+// temporary file is needed.
+//
+// gzip  : always available (zlib)
+// zstd  : build with TSE_WITH_ZSTD and link -lzstd
+
+struct InputMetrics {
+    std::string codec;          // "raw", "gzip", "zstd"
+    uint64_t compressedBytes{};
+    uint64_t outputBytes{};     // bytes handed to the caller
+    uint64_t decodeNs{};        // time spent inside the decompressor
+    uint64_t frames{};          // zstd frames / gzip members
+};
+
+class InputSource {
+public:
+    virtual ~InputSource() = default;
+
+    // Fill up to cap bytes. Returns bytes read, 0 on EOF, -1 on error.
+    virtual long read(uint8_t* dst, size_t cap) = 0;
+
+    // Advance n bytes of output (checkpoint resume). Raw files seek,
+    // archives decode and discard. False if the stream is shorter.
+    virtual bool skip(uint64_t n);
+
+    const InputMetrics& metrics() const { return _m; }
+
+    // Open path and pick the codec by magic bytes.
+    // threads > 1 decodes the frames of a multi-frame zstd file in parallel;
+    // single-frame files (the zstd CLI default) are always streamed.
+    static std::unique_ptr<InputSource> open(const std::string& path, int threads = 1);
+
+protected:
+    InputMetrics _m;
+};
+
+#endif // INPUT_SOURCE_H
@@ -0,0 +1,205 @@
+#include "RefJoin.h"
+#include "AsyncWriter.h"
+#include "Checkpoint.h"
+#include <cstdio>
+#include <cstring>
+
+using namespace std;
+
+RefJoin::RefJoin(AsyncSink* out, size_t maxDeferred, size_t maxSymbols)
+    : _out(out), _syms(maxSymbols)
+{
+    _refs.resize(_syms.capacity());
+    _firstHeld.assign(_syms.capacity(), -1);
+    _lastHeld.assign(_syms.capacity(), -1);
+    _ring.resize(maxDeferred ? maxDeferred : 1);
+}
+
+// The base header's last title is one short of its 16-wide column
+string RefJoin::header(const string& baseHeader) {
+    return baseHeader + "  Stock Name       Ref Price  Up Limit   Down Limit Limit Change     Change %";
+}
+
+const RefEntry* RefJoin::find(const string& stockId) const {
+    int sym = _syms.find(packId(stockId));
+    return (sym >= 0 && _refs[sym].known) ? &_refs[sym] : nullptr;
+}
+
+// Base row + " name ref up dn flag change change%"; the change columns are
+// left out without a trade, everything after the flag without a reference
+void RefJoin::write(string_view line, const RefEntry* ref, bool trade, double lastPx) {
+    char tail[160];     // name is at most 24 bytes (16 Big5 bytes as UTF-8)
+    int n;
+    if (!ref) {
+        n = snprintf(tail, sizeof(tail), " %-16s %-10s %-10s %-10s %-5s", "", "", "", "", "?");
+    } else {
+        const char* flag = "-";
+        if (trade && ref->upPrice > 0 && lastPx >= ref->upPrice) flag = "U";
+        else if (trade && ref->dnPrice > 0 && lastPx <= ref->dnPrice) flag = "D";
+        if (trade && ref->refPrice > 0) {
+            double chg = lastPx - ref->refPrice;
+            n = snprintf(tail, sizeof(tail), " %-16s %-10.4f %-10.4f %-10.4f %-5s %-10.4f %.2f",
+                         ref->name.c_str(), ref->refPrice, ref->upPrice, ref->dnPrice, flag,
+                         chg, chg / ref->refPrice * 100.0);
+        } else {
+            n = snprintf(tail, sizeof(tail), " %-16s %-10.4f %-10.4f %-10.4f %-5s",
+                         ref->name.c_str(), ref->refPrice, ref->upPrice, ref->dnPrice, flag);
+        }
+    }
+    _out->write(line.data(), line.size());
+    if (n > 0) _out->write(tail, (size_t)n);
+    _out->put('\n');
+}
+
+void RefJoin::onRef(const Tse01Record& r) {
+    int sym = _syms.slotOf(packId(r.stockId));
+    if (sym < 0) { _overflow++; return; }
+
+    RefEntry& e = _refs[sym];
+    e.refPrice = r.refPrice;
+    e.upPrice = r.upPrice;
+    e.dnPrice = r.dnPrice;
+    size_t len = r.stockName.find_last_not_of(' ');
+    e.name.assign(r.stockName, 0, len == string::npos ? 0 : len + 1);
+    e.known = true;
+
+    // Rows that waited for this symbol, oldest first
+    for (int32_t i = _firstHeld[sym]; i >= 0; ) {
+        Held& h = _ring[i];
+        write(h.line, &e, h.trade, h.lastPx);
+        h.sym = -1;
+        _live--;
+        _released++;
+        i = h.next;
+    }
+    _firstHeld[sym] = _lastHeld[sym] = -1;
+    skipWritten();
+}
+
+void RefJoin::onQuote(const Tse06Record& r, string_view line) {
+    const bool trade = tse06HasTrade(r.itemBitmap);
+    int sym = _syms.slotOf(packId(r.stockId));
+    if (sym < 0) {
+        _overflow++;
+        write(line, nullptr, trade, r.lastPx);
+        return;
+    }
+    if (_refs[sym].known) {
+        _joined++;
+        write(line, &_refs[sym], trade, r.lastPx);
+        return;
+    }
+    hold(sym, line, trade, r.lastPx);
+}
+
+void RefJoin::hold(int sym, string_view line, bool trade, double lastPx) {
+    if (_count == _ring.size()) releaseHead();
+
+    int32_t idx = (int32_t)((_head + _count) % _ring.size());
+    Held& h = _ring[idx];
+    h.line.assign(line.data(), line.size());
+    h.sym = sym;
+    h.next = -1;
+    h.lastPx = lastPx;
+    h.trade = trade;
+    if (_lastHeld[sym] >= 0) _ring[_lastHeld[sym]].next = idx;
+    else _firstHeld[sym] = idx;
+    _lastHeld[sym] = idx;
+
+    _count++;
+    _live++;
+    _deferred++;
+    if (_live > _maxHeld) _maxHeld = _live;
+}
+
+// Ring full: the oldest row (first of its symbol) goes out without reference
+void RefJoin::releaseHead() {
+    Held& h = _ring[_head];
+    if (h.sym >= 0) {
+        write(h.line, nullptr, h.trade, h.lastPx);
+        _firstHeld[h.sym] = h.next;
+        if (h.next < 0) _lastHeld[h.sym] = -1;
+        h.sym = -1;
+        _live--;
+        _expired++;
+    }
+    _head = (_head + 1) % _ring.size();
+    _count--;
+    skipWritten();
+}
+
+void RefJoin::skipWritten() {
+    while (_count > 0 && _ring[_head].sym < 0) {
+        _head = (_head + 1) % _ring.size();
+        _count--;
+    }
+}
+
+void RefJoin::flush() {
+    while (_count > 0) releaseHead();
+}
+
+void RefJoin::saveState(StateWriter& w) const {
+    w.put<uint64_t>(_syms.size());
+    for (size_t i = 0; i < _syms.size(); ++i) {
+        const RefEntry& e = _refs[i];
+        w.put(_syms.key(i));
+        w.put(e.known);
+        w.put(e.refPrice);
+        w.put(e.upPrice);
+        w.put(e.dnPrice);
+        w.putString(e.name);
+    }
+    w.put<uint64_t>(_live);
+    for (size_t k = 0; k < _count; ++k) {
+        const Held& h = _ring[(_head + k) % _ring.size()];
+        if (h.sym < 0) continue;
+        w.put(h.sym);
+        w.put(h.lastPx);
+        w.put(h.trade);
+        w.putString(h.line);
+    }
+    w.put(_joined);
+    w.put(_deferred);
+    w.put(_released);
+    w.put(_expired);
+    w.put(_overflow);
+    w.put<uint64_t>(_maxHeld);
+}
+
+bool RefJoin::loadState(StateReader& r) {
+    uint64_t nSyms = 0, live = 0, maxHeld = 0;
+    if (!r.get(nSyms) || nSyms > _syms.capacity()) return false;
+    for (size_t i = 0; i < nSyms && r.ok(); ++i) {
+        uint64_t key = 0;
+        r.get(key);
+        if (key == 0 || _syms.slotOf(key) != (int)i) return false;
+        RefEntry& e = _refs[i];
+        r.get(e.known);
+        r.get(e.refPrice);
+        r.get(e.upPrice);
+        r.get(e.dnPrice);
+        r.getString(e.name);
+    }
+    if (!r.get(live) || live > _ring.size()) return false;
+    for (uint64_t k = 0; k < live && r.ok(); ++k) {
+        int32_t sym = -1;
+        double lastPx = 0;
+        bool trade = false;
+        string line;
+        r.get(sym);
+        r.get(lastPx);
+        r.get(trade);
+        r.getString(line);
+        if (sym < 0 || (size_t)sym >= _syms.size()) return false;
+        hold(sym, line, trade, lastPx);
+    }
+    r.get(_joined);
+    r.get(_deferred);
+    r.get(_released);
+    r.get(_expired);
+    r.get(_overflow);
+    r.get(maxHeld);
+    _maxHeld = (size_t)maxHeld;
+    return r.ok();
+}
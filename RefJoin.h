@@ -0,0 +1,100 @@
+#ifndef REF_JOIN_H
+#define REF_JOIN_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "TseFmt01Parser.h"
+#include "TseFmt06Parser.h"
+#include "SymbolTable.h"
+
+class AsyncSink;
+class StateWriter;
+class StateReader;
+
+// Format 06 rows joined in-process with Format 01 reference data
+// (main --enrich), so consumers do not have to merge the two CSVs.
+//
+// Format 01 records fill a dense per-symbol table; symbols map to slots
+// through a SymbolTable keyed by the packed stock code, so the join is one
+// probe and one array index per message. Each Format 06 row is written with
+// name, reference, limit-up, limit-down, an at-limit flag (U / D) and the
+// change versus reference.
+//
+// A Format 06 row whose symbol has no Format 01 yet is held in a bounded
+// FIFO ring, chained per symbol. When the Format 01 arrives the symbol's
+// rows are released enriched; when the ring is full (or on flush()) the
+// oldest row is written without reference columns (flag '?'). Rows of one
+// symbol keep their order; rows of different symbols may be reordered.
+
+struct RefEntry {
+    double      refPrice{};
+    double      upPrice{};
+    double      dnPrice{};
+    std::string name;       // UTF-8, trailing blanks trimmed
+    bool        known{};
+};
+
+class RefJoin {
+public:
+    // out: the Format 06 output. maxDeferred: rows held waiting for Format 01
+    RefJoin(AsyncSink* out, size_t maxDeferred = 65536, size_t maxSymbols = 65536);
+
+    // Header of the base Format 06 row + reference columns
+    static std::string header(const std::string& baseHeader);
+
+    // Add / replace reference data; releases rows waiting for this symbol
+    void onRef(const Tse01Record& r);
+
+    // Write (or defer) one Format 06 row; line: the base row, no newline
+    void onQuote(const Tse06Record& r, std::string_view line);
+
+    // Write every deferred row (end of input)
+    void flush();
+
+    const RefEntry* find(const std::string& stockId) const;
+
+    uint64_t joined()   const { return _joined; }     // written with reference at once
+    uint64_t deferred() const { return _deferred; }   // held for a later Format 01
+    uint64_t released() const { return _released; }   // held, then written with reference
+    uint64_t expired()  const { return _expired; }    // held, then written without
+    uint64_t symbolOverflow() const { return _overflow; }
+    size_t   maxHeld()  const { return _maxHeld; }
+
+    // Checkpoint: reference table, held rows, counters
+    void saveState(StateWriter& w) const;
+    bool loadState(StateReader& r);
+
+private:
+    struct Held {
+        std::string line;
+        int32_t     sym;        // -1: already written
+        int32_t     next;       // next held row of the same symbol (-1: last)
+        double      lastPx;
+        bool        trade;
+    };
+
+    void write(std::string_view line, const RefEntry* ref, bool trade, double lastPx);
+    void hold(int sym, std::string_view line, bool trade, double lastPx);
+    void releaseHead();
+    void skipWritten();
+
+    AsyncSink*            _out;
+    SymbolTable           _syms;          // packed stock id -> dense slot
+    std::vector<RefEntry> _refs;          // dense slot -> reference data
+    std::vector<int32_t>  _firstHeld;     // dense slot -> oldest held row (-1: none)
+    std::vector<int32_t>  _lastHeld;
+
+    std::vector<Held>     _ring;          // held rows, FIFO
+    size_t                _head = 0;
+    size_t                _count = 0;     // ring entries in use (written ones included)
+    size_t                _live = 0;      // rows still waiting
+    size_t                _maxHeld = 0;
+
+    uint64_t _joined = 0, _deferred = 0, _released = 0, _expired = 0, _overflow = 0;
+};
+
+#endif // REF_JOIN_H
@@ -0,0 +1,319 @@
+#include "ShmBus.h"
+#include "SymbolTable.h"
+#include <iostream>
+#include <chrono>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <cerrno>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+using namespace std;
+
+uint64_t shmNowNs() {
+    return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static const int SNAP_RETRIES = 1 << 20;   // snapshot reads of a busy entry
+
+static uint32_t roundPow2(uint32_t v) {
+    uint32_t p = 1;
+    while (p < v) p <<= 1;
+    return p;
+}
+
+static void copyId(char* dst, size_t cap, const string& s) {
+    memset(dst, 0, cap);
+    memcpy(dst, s.data(), s.size() < cap - 1 ? s.size() : cap - 1);
+}
+
+static size_t regionBytes(uint32_t slots, uint32_t snap) {
+    return sizeof(ShmHeader) + (size_t)slots * sizeof(ShmSlot) + (size_t)snap * sizeof(ShmSnapEntry);
+}
+
+// ---- ShmRegion ------------------------------------------------------------------
+
+ShmRegion::~ShmRegion() {
+    if (!_p) return;
+#ifdef _WIN32
+    UnmapViewOfFile(_p);
+    CloseHandle((HANDLE)_handle);
+#else
+    munmap(_p, _size);
+#endif
+}
+
+bool ShmRegion::create(const string& name, size_t bytes) {
+    _name = name;
+    _size = bytes;
+    _owner = true;
+#ifdef _WIN32
+    HANDLE h = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                  (DWORD)((uint64_t)bytes >> 32), (DWORD)bytes, name.c_str());
+    if (!h) return false;
+    if (GetLastError() == ERROR_ALREADY_EXISTS) {
+        // Still held by another process (the mapping goes with its last handle)
+        CloseHandle(h);
+        return false;
+    }
+    _handle = h;
+    _p = MapViewOfFile(h, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+#else
+    string path = "/" + name;
+    int fd = shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) return false;                 // EEXIST: see ShmPublisher::create
+    if (ftruncate(fd, (off_t)bytes) != 0) { ::close(fd); return false; }
+    void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    _p = (p == MAP_FAILED) ? nullptr : p;
+#endif
+    if (_p) memset(_p, 0, bytes);
+    return _p != nullptr;
+}
+
+bool ShmRegion::open(const string& name) {
+    _name = name;
+    _owner = false;
+#ifdef _WIN32
+    HANDLE h = OpenFileMappingA(FILE_MAP_READ, FALSE, name.c_str());
+    if (!h) return false;
+    _handle = h;
+    _p = MapViewOfFile(h, FILE_MAP_READ, 0, 0, 0);
+    MEMORY_BASIC_INFORMATION mi;
+    if (_p && VirtualQuery(_p, &mi, sizeof(mi))) _size = mi.RegionSize;
+#else
+    string path = "/" + name;
+    int fd = shm_open(path.c_str(), O_RDONLY, 0);
+    if (fd < 0) return false;
+    struct stat stt;
+    if (fstat(fd, &stt) != 0) { ::close(fd); return false; }
+    _size = (size_t)stt.st_size;
+    void* p = mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    _p = (p == MAP_FAILED) ? nullptr : p;
+#endif
+    return _p != nullptr;
+}
+
+void ShmRegion::unlink() {
+    if (_owner) unlinkName(_name);
+}
+
+void ShmRegion::unlinkName(const string& name) {
+#ifndef _WIN32
+    shm_unlink(("/" + name).c_str());
+#else
+    (void)name;
+#endif
+}
+
+// Pid of the live publisher of an existing segment, 0 if there is none
+// (no segment, not initialised, or its publisher has exited)
+static uint64_t livePublisher(const string& name) {
+#ifdef _WIN32
+    ShmRegion r;
+    return r.open(name) ? 1 : 0;              // exists only while a process holds it
+#else
+    ShmRegion r;
+    if (!r.open(name) || r.size() < sizeof(ShmHeader)) return 0;
+    const ShmHeader* h = static_cast<const ShmHeader*>(r.data());
+    if (h->magic != SHM_MAGIC) return 0;
+    uint64_t pid = h->publisherPid.load(memory_order_acquire);
+    if (pid == 0) return 0;
+    if (kill((pid_t)pid, 0) == 0 || errno == EPERM) return pid;
+    return 0;
+#endif
+}
+
+// ---- ShmPublisher ---------------------------------------------------------------
+
+bool ShmPublisher::create(const string& name, uint32_t slotCount, uint32_t snapSize) {
+    slotCount = roundPow2(slotCount ? slotCount : 1);
+    snapSize  = roundPow2(snapSize ? snapSize : 1);
+    const size_t bytes = regionBytes(slotCount, snapSize);
+    bool ok = _shm.create(name, bytes);
+    if (!ok) {
+        // Name taken: never take over a running publisher's segment, only
+        // replace one left behind by a publisher that has exited
+        if (uint64_t pid = livePublisher(name)) {
+            cerr << "[ERROR] shared memory " << name << " is in use by publisher pid " << pid << ".\n";
+            return false;
+        }
+        ShmRegion::unlinkName(name);
+        ok = _shm.create(name, bytes);
+    }
+    if (!ok) {
+        cerr << "[ERROR] shared memory " << name << " cannot create.\n";
+        return false;
+    }
+
+    char* base = static_cast<char*>(_shm.data());
+    _hdr   = reinterpret_cast<ShmHeader*>(base);
+    _slots = reinterpret_cast<ShmSlot*>(base + sizeof(ShmHeader));
+    _snap  = reinterpret_cast<ShmSnapEntry*>(base + sizeof(ShmHeader) + (size_t)slotCount * sizeof(ShmSlot));
+
+    _hdr->version   = SHM_VERSION;
+    _hdr->slotCount = slotCount;
+    _hdr->snapSize  = snapSize;
+    _hdr->writeIndex.store(0, memory_order_relaxed);
+#ifndef _WIN32
+    _hdr->publisherPid.store((uint64_t)getpid(), memory_order_relaxed);
+#endif
+    // Magic last: readers treat the region as ready once it is set
+    atomic_thread_fence(memory_order_release);
+    _hdr->magic = SHM_MAGIC;
+    return true;
+}
+
+ShmSlot& ShmPublisher::begin(uint32_t type, uint64_t ns) {
+    ShmSlot& s = _slots[_next & (_hdr->slotCount - 1)];
+    s.seq.store(2 * _next + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    s.publishNs = ns;
+    s.type = type;
+    return s;
+}
+
+void ShmPublisher::commit(ShmSlot& s) {
+    s.seq.store(2 * _next + 2, memory_order_release);
+    _next++;
+    _hdr->writeIndex.store(_next, memory_order_release);
+}
+
+void ShmPublisher::publish(const Tse01Record& r) {
+    if (!_hdr) return;
+    ShmSlot& s = begin(SHM_FMT01, shmNowNs());
+    ShmQuote01& q = s.q01;
+    copyId(q.stockId, sizeof(q.stockId), r.stockId);
+    copyId(q.stockName, sizeof(q.stockName), r.stockName);
+    q.refPx = pxToTicks(r.refPrice);
+    q.upPx  = pxToTicks(r.upPrice);
+    q.dnPx  = pxToTicks(r.dnPrice);
+    q.seq   = 0;
+    for (char c : r.seq) q.seq = q.seq * 10 + (uint32_t)(c - '0');
+    q.checksumOK = r.checksumOK ? 1 : 0;
+    commit(s);
+}
+
+void ShmPublisher::publish(const Tse06Record& r) {
+    if (!_hdr) return;
+    uint64_t ns = shmNowNs();
+    ShmSlot& s = begin(SHM_FMT06, ns);
+    copyId(s.q06.stockId, sizeof(s.q06.stockId), r.stockId);
+    recordToState(r, s.q06.book);
+    commit(s);
+    updateSnapshot(s.q06, ns);
+}
+
+void ShmPublisher::updateSnapshot(const ShmQuote06& q, uint64_t ns) {
+    const uint32_t mask = _hdr->snapSize - 1;
+    uint64_t key = packId(q.stockId, sizeof(q.stockId));
+    uint32_t h = (uint32_t)hashKey(key) & mask;
+
+    for (uint32_t probe = 0; probe <= mask; ++probe, h = (h + 1) & mask) {
+        ShmSnapEntry& e = _snap[h];
+        uint64_t k = e.key.load(memory_order_relaxed);
+        if (k != 0 && k != key) continue;
+
+        uint64_t v = e.version.load(memory_order_relaxed);
+        e.version.store(v + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        e.publishNs = ns;
+        e.q = q;
+        e.version.store(v + 2, memory_order_release);
+        // Publish the key after the first full copy so readers never see a half entry
+        if (k == 0) e.key.store(key, memory_order_release);
+        return;
+    }
+    _snapOverflow++;
+}
+
+// ---- ShmReader ------------------------------------------------------------------
+
+bool ShmReader::open(const string& name, bool fromStart) {
+    if (!_shm.open(name)) return false;
+    char* base = static_cast<char*>(_shm.data());
+    _hdr = reinterpret_cast<ShmHeader*>(base);
+    if (_shm.size() < sizeof(ShmHeader) || _hdr->magic != SHM_MAGIC || _hdr->version != SHM_VERSION) {
+        _hdr = nullptr;
+        return false;
+    }
+    atomic_thread_fence(memory_order_acquire);
+    if (_shm.size() < regionBytes(_hdr->slotCount, _hdr->snapSize)) {
+        _hdr = nullptr;
+        return false;
+    }
+    _slots = reinterpret_cast<ShmSlot*>(base + sizeof(ShmHeader));
+    _snap  = reinterpret_cast<ShmSnapEntry*>(base + sizeof(ShmHeader) + (size_t)_hdr->slotCount * sizeof(ShmSlot));
+
+    uint64_t w = _hdr->writeIndex.load(memory_order_acquire);
+    if (fromStart) _next = (w > _hdr->slotCount) ? w - _hdr->slotCount : 0;
+    else           _next = w;
+    return true;
+}
+
+ShmReader::Status ShmReader::poll(ShmMessage& out) {
+    if (!_hdr) return NONE;
+    const ShmSlot& s = _slots[_next & (_hdr->slotCount - 1)];
+    const uint64_t want = 2 * _next + 2;
+
+    uint64_t s1 = s.seq.load(memory_order_acquire);
+    if (s1 < want) return NONE;            // not published yet (or being written)
+
+    if (s1 == want) {
+        out.index = _next;
+        out.publishNs = s.publishNs;
+        out.type = s.type;
+        if (out.type == SHM_FMT01) memcpy(&out.q01, &s.q01, sizeof(out.q01));
+        else                       memcpy(&out.q06, &s.q06, sizeof(out.q06));
+        atomic_thread_fence(memory_order_acquire);
+        if (s.seq.load(memory_order_relaxed) == want) {
+            _next++;
+            return OK;
+        }
+    }
+
+    // Lapped: jump to the oldest slot that is still intact
+    uint64_t w = _hdr->writeIndex.load(memory_order_acquire);
+    uint64_t oldest = (w > _hdr->slotCount) ? w - _hdr->slotCount + 1 : 0;
+    if (oldest > _next) {
+        _lost += oldest - _next;
+        _next = oldest;
+    } else {
+        _lost++;
+        _next++;
+    }
+    return OVERRUN;
+}
+
+bool ShmReader::snapshot(const string& stockId, ShmQuote06& out) const {
+    if (!_hdr) return false;
+    const uint32_t mask = _hdr->snapSize - 1;
+    uint64_t key = packId(stockId.data(), stockId.size());
+    uint32_t h = (uint32_t)hashKey(key) & mask;
+
+    for (uint32_t probe = 0; probe <= mask; ++probe, h = (h + 1) & mask) {
+        const ShmSnapEntry& e = _snap[h];
+        uint64_t k = e.key.load(memory_order_acquire);
+        if (k == 0) return false;
+        if (k != key) continue;
+        // Bounded: a publisher that died mid-update leaves the version odd
+        for (int tries = 0; tries < SNAP_RETRIES; ++tries) {
+            uint64_t v1 = e.version.load(memory_order_acquire);
+            if (v1 & 1) continue;             // writer busy, retry
+            memcpy(&out, &e.q, sizeof(out));
+            atomic_thread_fence(memory_order_acquire);
+            if (e.version.load(memory_order_relaxed) == v1) return true;
+        }
+        return false;
+    }
+    return false;
+}
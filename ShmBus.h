@@ -0,0 +1,171 @@
+#ifndef SHM_BUS_H
+#define SHM_BUS_H
+
+#include <string>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+#include "BookLog.h"          // BookState: fixed-layout Format 06 state
+#include "TseFmt01Parser.h"
+#include "TseFmt06Parser.h"
+
+// Shared-memory distribution of decoded quotes to local processes.
+//
+// One writer (the parser, --shm NAME) and any number of readers map the
+// same region:
+//
+//   ShmHeader
+//   ShmSlot[slotCount]        broadcast ring of Format 01 / 06 records
+//   ShmSnapEntry[snapSize]    latest book per symbol (open addressing)
+//
+// Ring slots and snapshot entries are seqlocks: the writer makes the
+// sequence odd while copying and even when done, readers copy and then
+// re-check it. Slot i is published with seq 2*i+2; a reader that finds a
+// larger value was lapped and reports the overrun instead of stale data.
+// Nothing in the region is a pointer, so it maps at any address.
+//
+// main unlinks the name when the run ends: readers already attached keep
+// their mapping, later ones cannot open it (no stale /dev/shm entries).
+
+static const uint64_t SHM_MAGIC   = 0x3142555345535431ULL;
+static const uint32_t SHM_VERSION = 1;
+
+enum ShmMsgType : uint32_t {
+    SHM_FMT01 = 1,
+    SHM_FMT06 = 6,
+};
+
+struct ShmQuote01 {
+    char     stockId[8];
+    char     stockName[32];   // UTF-8, NUL padded
+    int64_t  refPx;           // ticks (0.0001)
+    int64_t  upPx;
+    int64_t  dnPx;
+    uint32_t seq;
+    uint8_t  checksumOK;
+    uint8_t  pad[3];
+};
+
+struct ShmQuote06 {
+    char      stockId[8];
+    BookState book;
+};
+
+struct alignas(64) ShmSlot {
+    std::atomic<uint64_t> seq;
+    uint64_t publishNs;       // steady clock at publish, for latency checks
+    uint32_t type;            // ShmMsgType
+    uint32_t pad;
+    union {
+        ShmQuote01 q01;
+        ShmQuote06 q06;
+    };
+};
+
+struct alignas(64) ShmSnapEntry {
+    std::atomic<uint64_t> version;  // seqlock
+    std::atomic<uint64_t> key;      // packed stock id, 0 = empty, set once
+    uint64_t   publishNs;
+    ShmQuote06 q;
+};
+
+struct alignas(64) ShmHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t slotCount;       // power of two
+    uint32_t snapSize;        // power of two
+    uint32_t pad;
+    alignas(64) std::atomic<uint64_t> writeIndex;   // next slot to publish
+    alignas(64) std::atomic<uint64_t> publisherPid;
+};
+
+// Reader-side copy of one ring slot
+struct ShmMessage {
+    uint64_t   index;
+    uint64_t   publishNs;
+    uint32_t   type;
+    ShmQuote01 q01;           // valid when type == SHM_FMT01
+    ShmQuote06 q06;           // valid when type == SHM_FMT06
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared seqlocks need lock-free atomics");
+
+// Shared mapping (POSIX shm_open / Win32 file mapping)
+class ShmRegion {
+public:
+    ~ShmRegion();
+    bool create(const std::string& name, size_t bytes);
+    bool open(const std::string& name);
+    void unlink();
+    static void unlinkName(const std::string& name);
+    void* data() const { return _p; }
+    size_t size() const { return _size; }
+private:
+    std::string _name;
+    void*  _p = nullptr;
+    size_t _size = 0;
+    void*  _handle = nullptr;  // Win32 only
+    bool   _owner = false;
+};
+
+class ShmPublisher {
+public:
+    // slotCount / snapSize are rounded up to powers of two. Fails if NAME
+    // belongs to a running publisher; a segment left by one that exited
+    // (publisherPid no longer alive) is replaced.
+    bool create(const std::string& name, uint32_t slotCount = 65536, uint32_t snapSize = 8192);
+
+    void publish(const Tse01Record& r);
+    void publish(const Tse06Record& r);
+
+    uint64_t published() const { return _next; }
+    uint64_t snapshotOverflow() const { return _snapOverflow; }
+
+    // Remove the name (readers keep their mapping)
+    void unlink() { _shm.unlink(); }
+
+private:
+    ShmSlot& begin(uint32_t type, uint64_t ns);
+    void     commit(ShmSlot& s);
+    void     updateSnapshot(const ShmQuote06& q, uint64_t ns);
+
+    ShmRegion     _shm;
+    ShmHeader*    _hdr = nullptr;
+    ShmSlot*      _slots = nullptr;
+    ShmSnapEntry* _snap = nullptr;
+    uint64_t      _next = 0;
+    uint64_t      _snapOverflow = 0;
+};
+
+class ShmReader {
+public:
+    enum Status { NONE, OK, OVERRUN };
+
+    // fromStart: replay what is still in the ring instead of starting live
+    bool open(const std::string& name, bool fromStart = false);
+
+    // Copy the next record. OVERRUN: reader was lapped, lost() tells how
+    // many records were skipped and the next call resumes at the oldest one.
+    Status poll(ShmMessage& out);
+
+    // Latest book of a symbol; false if unknown, or if the entry stays
+    // mid-update (its publisher died while writing it)
+    bool snapshot(const std::string& stockId, ShmQuote06& out) const;
+
+    uint64_t lost() const { return _lost; }
+    uint64_t position() const { return _next; }
+
+private:
+    ShmRegion     _shm;
+    ShmHeader*    _hdr = nullptr;
+    ShmSlot*      _slots = nullptr;
+    ShmSnapEntry* _snap = nullptr;
+    uint64_t      _next = 0;
+    uint64_t      _lost = 0;
+};
+
+// Steady clock in ns; CLOCK_MONOTONIC is shared by processes on one host
+uint64_t shmNowNs();
+
+#endif // SHM_BUS_H
@@ -12,6 +12,7 @@ static const int MAX_MSG_LEN = 4096;
 void StreamFramer::feed(const uint8_t* data, size_t n, Callback cb) {
     // Safety check: prevent buffer from growing indefinitely
     if (_buf.size() > MAX_BUFFER) {
+        _bufOffset += _buf.size();
         _buf.clear();
     }
     
@@ -23,6 +24,7 @@ void StreamFramer::feed(const uint8_t* data, size_t n, Callback cb) {
         if (escPos < 0) {
             // if ESC not found, clear buffer to save space 
             // cause can't have a valid message start
+            _bufOffset += _buf.size();
             _buf.clear();
             return;
         }
@@ -30,6 +32,7 @@ void StreamFramer::feed(const uint8_t* data, size_t n, Callback cb) {
         // Discard garbage before ESC
         if (escPos > 0) {
             _buf.erase(_buf.begin(), _buf.begin() + escPos);
+            _bufOffset += escPos;
         }
 
         // 2. Peek header to get message length and format
@@ -48,6 +51,7 @@ void StreamFramer::feed(const uint8_t* data, size_t n, Callback cb) {
             // if size >= 10 and still failed, drop one byte and retry.
             if ((int)_buf.size() >= 10) {
                 _buf.erase(_buf.begin());
+                _bufOffset++;
                 continue;
             }
             return; // Wait for more data
@@ -62,6 +66,7 @@ void StreamFramer::feed(const uint8_t* data, size_t n, Callback cb) {
         if (msgLen <= 0 || msgLen > MAX_MSG_LEN) {
             // Invalid length, discard and try next
             _buf.erase(_buf.begin());
+            _bufOffset++;
             continue;
         }
 
@@ -80,13 +85,15 @@ void StreamFramer::feed(const uint8_t* data, size_t n, Callback cb) {
             // invalid terminator, this not a valid message.
             // discard the ESC and continue searching.
             _buf.erase(_buf.begin()); 
+            _bufOffset++;
             continue;
         }
 
-        // 5. Remove the processed message from buffer
-        _buf.erase(_buf.begin(), _buf.begin() + msgLen);
-
-        // 6. Dispatch
+        // 5. Dispatch (messageOffset() still points at this message)
         cb(one, fmt);
+
+        // 6. Remove the processed message from buffer
+        _buf.erase(_buf.begin(), _buf.begin() + msgLen);
+        _bufOffset += msgLen;
     }
 }
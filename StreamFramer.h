@@ -9,6 +9,7 @@
 class StreamFramer {
 private:
     std::vector<uint8_t> _buf;
+    uint64_t _bufOffset = 0;   // stream offset of _buf[0]
     const size_t MAX_BUFFER = 1024 * 1024 * 10; // 10MB limit to prevent memory exhaustion
 public:
     // Callback function type: (message_data, format_version)
@@ -18,6 +19,20 @@ public:
     // for each complete message found.
     void feed(const uint8_t* data, size_t n, Callback cb);
 
+    // Stream offset of the message being dispatched (valid inside the callback)
+    uint64_t messageOffset() const { return _bufOffset; }
+
+    // Start counting offsets from a given stream position (empty framer only)
+    void setStreamOffset(uint64_t off) { _bufOffset = off; }
+
+    // Drop a held partial message (input rotated / truncated) and restart at off
+    void reset(uint64_t off = 0) { _buf.clear(); _bufOffset = off; }
+
+    // Bytes held between feeds (partial message) and messageOffset();
+    // saved in checkpoints and put back with restore()
+    const std::vector<uint8_t>& pending() const { return _buf; }
+    void restore(uint64_t off, const uint8_t* p, size_t n) { _buf.assign(p, p + n); _bufOffset = off; }
+
 };
 
 #endif // STREAM_FRAMER_H
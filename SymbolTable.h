@@ -0,0 +1,84 @@
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+// Pack up to 8 ASCII bytes of the stock id into a non-zero key
+inline uint64_t packId(const char* id, size_t n) {
+    uint64_t k = 0;
+    memcpy(&k, id, n < 8 ? n : 8);
+    return k;
+}
+
+inline uint64_t packId(const std::string& id) {
+    return packId(id.data(), id.size());
+}
+
+inline uint64_t hashKey(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    return k;
+}
+
+// Packed stock id -> dense slot 0..capacity()-1, through a fixed
+// open-addressing table (linear probing, at most half full). Slots are
+// handed out in first-seen order and never freed, so callers keep their
+// per-symbol state in flat arrays indexed by slot.
+class SymbolTable {
+public:
+    explicit SymbolTable(size_t maxSymbols)
+        : _cap(maxSymbols ? maxSymbols : 1)
+    {
+        size_t tbl = 1;
+        while (tbl < _cap * 2) tbl <<= 1;
+        _mask = tbl - 1;
+        _keys.assign(tbl, 0);
+        _slotOfKey.assign(tbl, -1);
+        _slotKey.assign(_cap, 0);
+    }
+
+    // Slot of key, assigning the next free one; -1 when all are taken
+    int slotOf(uint64_t key) {
+        size_t h = (size_t)hashKey(key) & _mask;
+        while (true) {
+            if (_keys[h] == key) return _slotOfKey[h];
+            if (_keys[h] == 0) {
+                if (_count >= _cap) return -1;
+                _keys[h] = key;
+                _slotOfKey[h] = (int32_t)_count;
+                _slotKey[_count] = key;
+                return (int)_count++;
+            }
+            h = (h + 1) & _mask;
+        }
+    }
+
+    // Slot of key, -1 if it was never seen
+    int find(uint64_t key) const {
+        size_t h = (size_t)hashKey(key) & _mask;
+        while (_keys[h] != 0) {
+            if (_keys[h] == key) return _slotOfKey[h];
+            h = (h + 1) & _mask;
+        }
+        return -1;
+    }
+
+    const uint64_t& key(size_t slot) const { return _slotKey[slot]; }
+    size_t size() const     { return _count; }
+    size_t capacity() const { return _cap; }
+
+private:
+    size_t                _cap;           // symbol slots
+    size_t                _mask;          // hash table size - 1
+    std::vector<uint64_t> _keys;          // hash table: packed stock id (0 = empty)
+    std::vector<int32_t>  _slotOfKey;     // hash table: dense slot
+    std::vector<uint64_t> _slotKey;       // dense slot -> key
+    size_t                _count = 0;
+};
+
+#endif // SYMBOL_TABLE_H
@@ -4,6 +4,9 @@
 #include <string>
 #include <cstdint>
 #include <memory>
+#include <string_view>
+
+#include "Arena.h"
 
 class TseBaseParser {
 public:
@@ -30,8 +33,25 @@ public:
         return "";
     }
 
+    // Same rows, formatted into the batch arena; valid until arena.reset()
+    virtual std::string_view recToCsv01(const void* rec, Arena& arena) const {
+        std::string s = recToCsv01(rec);
+        return arena.copy(s.data(), s.size());
+    }
+
+    virtual std::string_view recToCsv06(const void* rec, Arena& arena) const {
+        std::string s = recToCsv06(rec);
+        return arena.copy(s.data(), s.size());
+    }
+
+    // Optional batch arena for string temporaries while parsing
+    void setArena(Arena* arena) { _arena = arena; }
+
     // Factory by fmtCode: "01"/"06"
     static std::unique_ptr<TseBaseParser> create(const std::string& fmt);
+
+protected:
+    Arena* _arena = nullptr;
 };
 
 #endif
@@ -63,6 +63,7 @@ public:
 
     // CSV C]5 ^
     std::string recToCsv01(const void* rec) const override;
+    std::string_view recToCsv01(const void* rec, Arena& arena) const override;
 };
 
 #endif
@@ -1,10 +1,13 @@
 #include "TseFmt06Parser.h"
 #include "Utils.h"
+#include "TseSchema.h"
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
+#include <cstdio>
 
 using std::string;
+using namespace tse;
 
 namespace {
     constexpr uint8_t ESC_BYTE = 0x1B;
@@ -25,69 +28,86 @@ static std::string map06ToCSV(const Tse06Record& src) {
     return oss.str();
 }
 
+// Tw  Tse06Record]̰Tǡ^
+using Fmt06FixedDecoder = Decoder<
+    Bind<Header::Esc,         &Tse06Record::esc>,
+    Bind<Header::BizType,     &Tse06Record::bizType>,     // "01"
+    Bind<Header::FmtCode,     &Tse06Record::fmtCode>,     // "06"
+    Bind<Header::FmtVer,      &Tse06Record::fmtVer>,      // "04"
+    Bind<Header::Seq,         &Tse06Record::seq>,
+    Bind<Fmt06::StockId,      &Tse06Record::stockId>,     // [11-16]
+    Bind<Fmt06::ItemBitmap,   &Tse06Record::itemBitmap>,  // [23]
+    Bind<Fmt06::LimitBitmap,  &Tse06Record::limitBitmap>, // [24]
+    Bind<Fmt06::StateBitmap,  &Tse06Record::stateBitmap>, // [25]
+    Bind<Fmt06::CumQty,       &Tse06Record::cumQty>>;     // [26-29]
+
+static_assert(Fmt06FixedDecoder::extent() == Fmt06::VAR_BEGIN, "fixed part must end where levels begin");
+
+using Level = Fmt06::Level;
+
+// @ɻq]Level 첾Hɰ_Iǡ^Fפ^ false]IsݪѪR^
+static inline bool readLevel(const uint8_t* msg, int& pos, int end, double& px, uint32_t& qty) {
+    const uint8_t* lv = msg + pos;
+    if (!inRange(pos, end, Level::Price::end)) return false;
+    (void)get<Level::Price>(lv, px);
+
+    if (!inRange(pos, end, Level::Qty::end)) return false;
+    (void)get<Level::Qty>(lv, qty);
+    pos += Level::size;
+    return true;
+}
+
 bool TseFmt06Parser::parseOneMSG06(const uint8_t* msg, int len, void* out) const {
-    if (!msg || !out || len < 32) return false;
+    if (!msg || !out || len < Fmt06::MIN_LEN) return false;
     if (msg[0] != ESC_BYTE) return false;
     if (!(msg[len-2] == CR_BYTE && msg[len-1] == LF_BYTE)) return false;
 
     Tse06Record& r = *static_cast<Tse06Record*>(out);
 
     // 1) HeaderGŧi׻ݵڪ
-    string sLen = bcdToDigitString(&msg[1], 2); // Byte2-3
     int declared = 0;
-    try { declared = std::stoi(sLen); } catch (...) { return false; }
+    (void)get<Header::MsgLen>(msg, declared);           // Byte2-3
     if (declared != len) return false;
+    r.msgLen = declared;
 
-    r.esc     = msg[0];
-    r.msgLen  = declared;
-    r.bizType = bcdToDigitString(&msg[3], 1); // "01"
-    r.fmtCode = bcdToDigitString(&msg[4], 1); // "06"
-    r.fmtVer  = bcdToDigitString(&msg[5], 1); // "04"
-    r.seq     = bcdToDigitString(&msg[6], 4); // 4B
-
-    // 2) Body Tw
-    r.stockId = asciiField(&msg[10], 6);                // [11-16]
-    if (!parseMatchTime_fromBCD6(&msg[16], r.matchTime))// [17-22]
-        return false;
-    r.itemBitmap  = msg[22];                            // [23]
-    r.limitBitmap = msg[23];                            // [24]
-    r.stateBitmap = msg[24];                            // [25]
-    if (!parseQty_fromBCD4(&msg[25], r.cumQty))         // [26-29]
+    // 2) Header + Body Tw
+    matchTime<Fmt06::MatchTime>(msg, r.matchTime);      // [17-22]
+    if (!Fmt06FixedDecoder::decode(msg, r))
         return false;
 
     // 3) ˬdX]XOR Byte2..̫@ BODY byteAP msg[len-3] ^
-    r.checksum = msg[len - 3];
+    r.checksum = msg[len - Fmt06::TRAILER];
     {
         uint8_t x = 0;
-        for (int i = 1; i <= len - 4; ++i) x ^= msg[i];
+        for (int i = 1; i <= len - Fmt06::TRAILER - 1; ++i) x ^= msg[i];
         r.calcXor  = x;
         r.checksumOK = (x == r.checksum);
     }
 
     // 4) ܰʰϡG  R N   M
-    const int payloadEnd = len - 3; // checksum m
-    int pos = 29;                   // wŪ msg[28]
+    const int payloadEnd = len - Fmt06::TRAILER; // checksum m
+    int pos = Fmt06::VAR_BEGIN;                  // wŪ msg[28]
 
     r.lastPx = 0.0; r.lastQty = 0;
     r.bidPx.fill(0.0);  r.bidQty.fill(0);
     r.askPx.fill(0.0);  r.askQty.fill(0);
 
-    const bool hasTrade   = (r.itemBitmap & 0b1000'0000) != 0;       // Bit7
+    const bool hasTrade   = tse06HasTrade(r.itemBitmap);             // Bit7
     const int  bidLvls    = (r.itemBitmap >> 4) & 0b0000'0111;       // 0..5
     const int  askLvls    = (r.itemBitmap >> 1) & 0b0000'0111;       // 0..5
     const bool onlyTrade  = (r.itemBitmap & 0b0000'0001) != 0;       // Bit0
-    const int  trendBits  = (r.limitBitmap & 0b0000'0011);
-    const bool isDeferred = (trendBits == 0b01 || trendBits == 0b10);// ȽwX
+    const bool isDeferred = tse06IsDeferred(r.limitBitmap);          // ȽwX
 
     // (a) q
     if (hasTrade) {
-        if (!inRange(pos, payloadEnd, 5)) { return true; }
-        (void)parsePrice_fromBCD5(&msg[pos], r.lastPx); pos += 5;
+        const uint8_t* lv = msg + pos;
+        if (!inRange(pos, payloadEnd, Level::Price::end)) { return true; }
+        (void)get<Level::Price>(lv, r.lastPx);
 
-        if (!inRange(pos, payloadEnd, 4)) { return true; }
+        if (!inRange(pos, payloadEnd, Level::Qty::end)) { return true; }
         uint32_t q = 0;
-        if (parseQty_fromBCD4(&msg[pos], q)) r.lastQty = (isDeferred ? 0u : q);
-        pos += 4;
+        if (get<Level::Qty>(lv, q)) r.lastQty = (isDeferred ? 0u : q);
+        pos += Level::size;
     }
 
     // (b) Ȧ  ȽwX  ѪR
@@ -95,25 +115,17 @@ bool TseFmt06Parser::parseOneMSG06(const uint8_t* msg, int len, void* out) const
 
     // (c) R N 
     {
-        const int nb = std::min(std::max(bidLvls, 0), 5);
+        const int nb = std::min(std::max(bidLvls, 0), Fmt06::MAX_LEVELS);
         for (int i = 0; i < nb; ++i) {
-            if (!inRange(pos, payloadEnd, 5)) { return true; }
-            (void)parsePrice_fromBCD5(&msg[pos], r.bidPx[i]); pos += 5;
-
-            if (!inRange(pos, payloadEnd, 4)) { return true; }
-            (void)parseQty_fromBCD4(&msg[pos], r.bidQty[i]);  pos += 4;
+            if (!readLevel(msg, pos, payloadEnd, r.bidPx[i], r.bidQty[i])) { return true; }
         }
     }
 
     // (d)  M 
     {
-        const int na = std::min(std::max(askLvls, 0), 5);
+        const int na = std::min(std::max(askLvls, 0), Fmt06::MAX_LEVELS);
         for (int i = 0; i < na; ++i) {
-            if (!inRange(pos, payloadEnd, 5)) { return true; }
-            (void)parsePrice_fromBCD5(&msg[pos], r.askPx[i]); pos += 5;
-
-            if (!inRange(pos, payloadEnd, 4)) { return true; }
-            (void)parseQty_fromBCD4(&msg[pos], r.askQty[i]);  pos += 4;
+            if (!readLevel(msg, pos, payloadEnd, r.askPx[i], r.askQty[i])) { return true; }
         }
     }
 
@@ -150,3 +162,26 @@ std::string TseFmt06Parser::recToCsv06(const void* rec) const {
     
     return oss.str();
 }
+
+// Same row as recToCsv06 (%-Nf / %-Nu match setw + left + fixed), into the batch arena
+std::string_view TseFmt06Parser::recToCsv06(const void* rec, Arena& arena) const {
+    if (!rec) return std::string_view();
+    const Tse06Record& r = *static_cast<const Tse06Record*>(rec);
+
+    const size_t cap = r.stockId.size() + r.matchTime.size() + 24 * 40;
+    char* buf = arena.reserve(cap);
+    char* o = buf;
+    char* end = buf + cap;
+
+    o += snprintf(o, end - o, "%-10s ", r.stockId.c_str());
+    for (int i = 0; i < 5; ++i) {
+        o += snprintf(o, end - o, "%-10.4f %-12u ", r.bidPx[i], (unsigned)r.bidQty[i]);
+    }
+    for (int i = 0; i < 5; ++i) {
+        o += snprintf(o, end - o, "%-10.4f %-12u ", r.askPx[i], (unsigned)r.askQty[i]);
+    }
+    o += snprintf(o, end - o, "%-10.4f %-12u %-16s", r.lastPx, (unsigned)r.lastQty, r.matchTime.c_str());
+
+    arena.shrinkLast(buf, cap, o - buf);
+    return std::string_view(buf, o - buf);
+}
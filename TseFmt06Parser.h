@@ -35,6 +35,17 @@ struct Tse06Record {
     bool    checksumOK{true};
 };
 
+// itemBitmap Bit7：含成交價量
+inline bool tse06HasTrade(uint8_t itemBitmap) {
+    return (itemBitmap & 0b1000'0000) != 0;
+}
+
+// limitBitmap 漲跌趨勢 Bit1-0 為 01 / 10：暫緩撮合（成交價為試算價，量為 0）
+inline bool tse06IsDeferred(uint8_t limitBitmap) {
+    const int trendBits = (limitBitmap & 0b0000'0011);
+    return trendBits == 0b01 || trendBits == 0b10;
+}
+
 class TseFmt06Parser : public TseBaseParser {
 public:
     bool parseOneMSG06(const uint8_t* msg, int len, void* out) const override;
@@ -56,6 +67,7 @@ public:
     }
     
     std::string recToCsv06(const void* rec) const override;
+    std::string_view recToCsv06(const void* rec, Arena& arena) const override;
 };
 
 #endif
@@ -0,0 +1,292 @@
+#ifndef TSE_SCHEMA_H
+#define TSE_SCHEMA_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+
+#include "Utils.h"
+
+// Compile-time description of TWSE message layouts.
+//
+// A field is a type carrying its byte offset, width, encoding and (for
+// PACK-BCD numbers) implied decimals. Decoders are generated from these
+// types: loops run over compile-time widths, so the compiler fully unrolls
+// them, and a Layout<> of fields static_asserts that the table is
+// contiguous and matches the message length. Binding a field to a record
+// member (Bind<Field, &Rec::member>) gives a record decoder; decoding a
+// subset of bindings is a projection.
+//
+// PACK-BCD numbers are decoded with integer arithmetic. Invalid nibbles
+// (> 9) fall back to the string-based helpers in Utils so results stay
+// identical to the original parsers.
+
+namespace tse {
+
+enum class Enc : uint8_t {
+    PackBcd,   // 2 digits per byte
+    Ascii,     // trimmed (asciiField)
+    Big5,      // converted to UTF-8
+    Bitmap,    // single raw byte of flags
+    Raw,       // opaque bytes, decoded as hex
+};
+
+template <int Off, int Width, Enc E, int Decimals = 0>
+struct Field {
+    static constexpr int offset   = Off;
+    static constexpr int width    = Width;
+    static constexpr int end      = Off + Width;
+    static constexpr Enc enc      = E;
+    static constexpr int decimals = Decimals;
+    static_assert(Off >= 0 && Width > 0, "bad field geometry");
+    static_assert(E != Enc::Bitmap || Width == 1, "bitmap fields are one byte");
+    static_assert(Decimals == 0 || E == Enc::PackBcd, "decimals only apply to PACK-BCD");
+    static_assert(Decimals <= 2 * Width, "more decimals than digits");
+};
+
+// Fields in byte order with no gap or overlap, ending at Len
+template <int Len, typename... Fs>
+struct Layout {
+    static constexpr int length = Len;
+
+    static constexpr bool contiguous() {
+        const int offs[] = {Fs::offset...};
+        const int ends[] = {Fs::end...};
+        for (size_t i = 1; i < sizeof...(Fs); ++i) {
+            if (offs[i] != ends[i - 1]) return false;
+        }
+        return offs[0] == 0 && ends[sizeof...(Fs) - 1] == Len;
+    }
+    static_assert(sizeof...(Fs) > 0, "empty layout");
+    static_assert(contiguous(), "layout has a gap or overlap, or does not match the length");
+};
+
+// ---- PACK-BCD primitives (W is a compile-time width) ----------------------------
+
+template <int W>
+inline bool bcdValid(const uint8_t* p) {
+    uint8_t bad = 0;
+    for (int i = 0; i < W; ++i) {
+        uint8_t hi = p[i] >> 4, lo = p[i] & 0xF;
+        bad |= (uint8_t)((hi > 9) | (lo > 9));
+    }
+    return bad == 0;
+}
+
+template <int W>
+inline uint64_t bcdValue(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < W; ++i) v = v * 100 + (p[i] >> 4) * 10 + (p[i] & 0xF);
+    return v;
+}
+
+// Same characters as bcdToDigitString, without the temporary
+template <int W>
+inline void bcdDigits(const uint8_t* p, char* out) {
+    for (int i = 0; i < W; ++i) {
+        out[2 * i]     = (char)('0' + (p[i] >> 4));
+        out[2 * i + 1] = (char)('0' + (p[i] & 0xF));
+    }
+}
+
+constexpr uint64_t pow10(int n) { return n == 0 ? 1 : 10 * pow10(n - 1); }
+
+// 6-byte PACK-BCD time -> "HH:MM:SS.mmmuuu" (same text as parseMatchTime_fromBCD6)
+template <class F>
+inline void matchTime(const uint8_t* msg, std::string& out) {
+    static_assert(F::enc == Enc::PackBcd && F::width == 6, "HHMMSSmmmuuu field expected");
+    char d[12];
+    bcdDigits<6>(msg + F::offset, d);
+    out.resize(15);
+    char* o = &out[0];
+    o[0] = d[0];  o[1] = d[1];  o[2] = ':';
+    o[3] = d[2];  o[4] = d[3];  o[5] = ':';
+    o[6] = d[4];  o[7] = d[5];  o[8] = '.';
+    for (int i = 0; i < 6; ++i) o[9 + i] = d[6 + i];
+}
+
+// ---- field decoders ---------------------------------------------------------------
+
+// Text: digits for PACK-BCD, trimmed ASCII, Big5 -> UTF-8, hex for raw bytes
+template <class F>
+inline bool get(const uint8_t* msg, std::string& out) {
+    const uint8_t* p = msg + F::offset;
+    if constexpr (F::enc == Enc::PackBcd) {
+        out.resize(2 * F::width);
+        bcdDigits<F::width>(p, &out[0]);
+    } else if constexpr (F::enc == Enc::Ascii) {
+        out = asciiField(p, F::width);
+    } else if constexpr (F::enc == Enc::Big5) {
+        out = big5ToUtf8(reinterpret_cast<const char*>(p), F::width);
+    } else {
+        static const char* hex = "0123456789ABCDEF";
+        out.resize(2 * F::width);
+        for (int i = 0; i < F::width; ++i) {
+            out[2 * i]     = hex[(p[i] >> 4) & 0xF];
+            out[2 * i + 1] = hex[p[i] & 0xF];
+        }
+    }
+    return true;
+}
+
+// Flag byte
+template <class F>
+inline bool get(const uint8_t* msg, uint8_t& out) {
+    static_assert(F::width == 1, "byte field expected");
+    out = msg[F::offset];
+    return true;
+}
+
+// Integer PACK-BCD (lengths, codes, quantities)
+template <class F>
+inline bool get(const uint8_t* msg, int& out) {
+    static_assert(F::enc == Enc::PackBcd && F::decimals == 0, "integer PACK-BCD field expected");
+    const uint8_t* p = msg + F::offset;
+    if (bcdValid<F::width>(p)) {
+        out = (int)bcdValue<F::width>(p);
+        return true;
+    }
+    try { out = std::stoi(bcdToDigitString(p, F::width)); }
+    catch (...) { out = 0; }
+    return true;
+}
+
+template <class F>
+inline bool get(const uint8_t* msg, uint32_t& out) {
+    static_assert(F::enc == Enc::PackBcd && F::decimals == 0, "integer PACK-BCD field expected");
+    const uint8_t* p = msg + F::offset;
+    if (bcdValid<F::width>(p)) {
+        out = (uint32_t)bcdValue<F::width>(p);
+        return true;
+    }
+    if constexpr (F::width == 4) return parseQty_fromBCD4(p, out);
+    try { out = (uint32_t)std::stoul(bcdToDigitString(p, F::width)); return true; }
+    catch (...) { return false; }
+}
+
+// Decimal PACK-BCD: same arithmetic as parsePrice_fromBCD5 (int + frac / 10^d)
+template <class F>
+inline bool get(const uint8_t* msg, double& out) {
+    static_assert(F::enc == Enc::PackBcd && F::decimals > 0, "decimal PACK-BCD field expected");
+    const uint8_t* p = msg + F::offset;
+    if (bcdValid<F::width>(p)) {
+        const uint64_t v = bcdValue<F::width>(p);
+        constexpr uint64_t scale = pow10(F::decimals);
+        out = (double)(v / scale) + (double)(v % scale) / (double)scale;
+        return true;
+    }
+    if constexpr (F::width == 5 && F::decimals == 4) return parsePrice_fromBCD5(p, out);
+    return false;
+}
+
+// ---- record binding / projection -----------------------------------------------
+
+template <class F, auto Member>
+struct Bind {
+    using field = F;
+    template <class Rec>
+    static bool apply(const uint8_t* msg, Rec& rec) { return get<F>(msg, rec.*Member); }
+};
+
+// Decode the listed bindings in order; stops at the first failure
+template <class... Bs>
+struct Decoder {
+    template <class Rec>
+    static bool decode(const uint8_t* msg, Rec& rec) {
+        return (Bs::apply(msg, rec) && ...);
+    }
+    // Furthest byte touched, for length checks
+    static constexpr int extent() {
+        int e = 0;
+        const int ends[] = {Bs::field::end...};
+        for (int x : ends) e = x > e ? x : e;
+        return e;
+    }
+};
+
+// ---- common header (both formats) ----------------------------------------------
+
+struct Header {
+    using Esc     = Field<0, 1, Enc::Bitmap>;
+    using MsgLen  = Field<1, 2, Enc::PackBcd>;
+    using BizType = Field<3, 1, Enc::PackBcd>;
+    using FmtCode = Field<4, 1, Enc::PackBcd>;
+    using FmtVer  = Field<5, 1, Enc::PackBcd>;
+    using Seq     = Field<6, 4, Enc::PackBcd>;
+};
+
+// ---- Format 01: stock basic data, fixed 114 bytes ------------------------------
+
+struct Fmt01 {
+    using StockId       = Field<10, 6, Enc::Ascii>;
+    using StockName     = Field<16, 16, Enc::Big5>;
+    using Industry      = Field<32, 2, Enc::Ascii>;
+    using SecType       = Field<34, 2, Enc::Ascii>;
+    using TradeNote     = Field<36, 2, Enc::Ascii>;
+    using AbnCode       = Field<38, 1, Enc::PackBcd>;
+    using Board         = Field<39, 1, Enc::Ascii>;
+    using RefPrice      = Field<40, 5, Enc::PackBcd, 4>;
+    using UpPrice       = Field<45, 5, Enc::PackBcd, 4>;
+    using DnPrice       = Field<50, 5, Enc::PackBcd, 4>;
+    using Non10Par      = Field<55, 1, Enc::Ascii>;
+    using AbnPromo      = Field<56, 1, Enc::Ascii>;
+    using SpecialAbn    = Field<57, 1, Enc::Ascii>;
+    using DayTradeCash  = Field<58, 1, Enc::Ascii>;
+    using ExemptSSR     = Field<59, 1, Enc::Ascii>;
+    using ExemptSBL     = Field<60, 1, Enc::Ascii>;
+    using MatchCycleSec = Field<61, 3, Enc::PackBcd>;
+    using WarrantRaw    = Field<64, 39, Enc::Raw>;
+    using OtherRaw      = Field<103, 7, Enc::Raw>;
+    using LineNote      = Field<110, 1, Enc::PackBcd>;
+    using Checksum      = Field<111, 1, Enc::Bitmap>;
+    using Terminal      = Field<112, 2, Enc::Raw>;
+
+    using Layout = tse::Layout<114,
+        Header::Esc, Header::MsgLen, Header::BizType, Header::FmtCode, Header::FmtVer, Header::Seq,
+        StockId, StockName, Industry, SecType, TradeNote, AbnCode, Board,
+        RefPrice, UpPrice, DnPrice,
+        Non10Par, AbnPromo, SpecialAbn, DayTradeCash, ExemptSSR, ExemptSBL,
+        MatchCycleSec, WarrantRaw, OtherRaw, LineNote, Checksum, Terminal>;
+
+    static constexpr int XOR_FIRST = Header::MsgLen::offset;   // checksum covers bytes 1..110
+    static constexpr int XOR_LAST  = LineNote::end - 1;
+};
+
+// ---- Format 06: real-time quotes, 32..131 bytes ---------------------------------
+
+struct Fmt06 {
+    using StockId     = Field<10, 6, Enc::Ascii>;
+    using MatchTime   = Field<16, 6, Enc::PackBcd>;   // HHMMSSmmmuuu
+    using ItemBitmap  = Field<22, 1, Enc::Bitmap>;
+    using LimitBitmap = Field<23, 1, Enc::Bitmap>;
+    using StateBitmap = Field<24, 1, Enc::Bitmap>;
+    using CumQty      = Field<25, 4, Enc::PackBcd>;
+
+    // Fixed part; the variable part starts at VAR_BEGIN
+    using FixedLayout = tse::Layout<29,
+        Header::Esc, Header::MsgLen, Header::BizType, Header::FmtCode, Header::FmtVer, Header::Seq,
+        StockId, MatchTime, ItemBitmap, LimitBitmap, StateBitmap, CumQty>;
+
+    static constexpr int VAR_BEGIN = CumQty::end;
+    static constexpr int TRAILER   = 3;                   // checksum + CR LF
+    static constexpr int MIN_LEN   = VAR_BEGIN + TRAILER;
+    static constexpr int MAX_LEVELS = 5;
+
+    // One price/qty group of the variable part (trade, bid N, ask M)
+    struct Level {
+        using Price = Field<0, 5, Enc::PackBcd, 4>;
+        using Qty   = Field<5, 4, Enc::PackBcd>;
+        using Layout = tse::Layout<9, Price, Qty>;
+        static constexpr int size = Layout::length;
+    };
+
+    static constexpr int MAX_LEN = MIN_LEN + (1 + 2 * MAX_LEVELS) * Level::size;
+};
+
+static_assert(Fmt06::MIN_LEN == 32,  "Format 06 minimum length is 32 bytes");
+static_assert(Fmt06::MAX_LEN == 131, "Format 06 maximum length is 131 bytes");
+
+} // namespace tse
+
+#endif // TSE_SCHEMA_H
@@ -1,4 +1,5 @@
 #include "Utils.h"
+#include "Arena.h"
 #include <iostream>
 #include <algorithm>
 #include <sstream>
@@ -169,3 +170,21 @@ string big5ToUtf8(const char* bytes, size_t len) {
     
     return ret;
 }
+
+// Big5 -> UTF-8 into the batch arena (wide buffer and result; no heap)
+string_view big5ToUtf8(const char* bytes, size_t len, Arena& arena) {
+    if (len == 0) return string_view();
+
+    int wLen = MultiByteToWideChar(CP_BIG5, 0, bytes, (int)len, NULL, 0);
+    if (wLen <= 0) return arena.copy(bytes, len);
+
+    wchar_t* w = arena.allocArray<wchar_t>((size_t)wLen);
+    MultiByteToWideChar(CP_BIG5, 0, bytes, (int)len, w, wLen);
+
+    int uLen = WideCharToMultiByte(CP_UTF8, 0, w, wLen, NULL, 0, NULL, NULL);
+    if (uLen <= 0) return arena.copy(bytes, len);
+
+    char* u = arena.allocChars((size_t)uLen);
+    WideCharToMultiByte(CP_UTF8, 0, w, wLen, u, uLen, NULL, NULL);
+    return string_view(u, (size_t)uLen);
+}
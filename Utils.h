@@ -4,6 +4,9 @@
 #include <string>
 #include <cstdint>
 #include <vector>
+#include <string_view>
+
+class Arena;
 
 using namespace std;
 
@@ -38,4 +41,7 @@ string asciiField(const uint8_t* p, int n);
 // Big5 -> UTF-8]Windows API D Windows h˦^ǡ^
 string big5ToUtf8(const char* bytes, size_t len);
 
+// Big5 -> UTF-8AȦsPGtmb妸 arena]g heap^
+std::string_view big5ToUtf8(const char* bytes, size_t len, Arena& arena);
+
 #endif
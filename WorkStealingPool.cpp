@@ -0,0 +1,105 @@
+#include "WorkStealingPool.h"
+
+using namespace std;
+
+// Worker identity of the calling thread (-1 outside any pool)
+static thread_local const WorkStealingPool* tlsPool = nullptr;
+static thread_local int tlsWorker = -1;
+
+WorkStealingPool::WorkStealingPool(int threads) {
+    if (threads < 1) threads = 1;
+    for (int i = 0; i < threads; ++i) _queues.emplace_back(new Queue());
+    for (int i = 0; i < threads; ++i) _workers.emplace_back(&WorkStealingPool::run, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        lock_guard<mutex> lk(_mu);
+        _quit = true;
+    }
+    _workCv.notify_all();
+    for (auto& t : _workers) t.join();
+}
+
+void WorkStealingPool::submit(Task t) {
+    int id = (tlsPool == this) ? tlsWorker : (int)(_rr++ % _queues.size());
+    _pending++;
+    {
+        lock_guard<mutex> lk(_queues[id]->mu);
+        _queues[id]->tasks.push_back(std::move(t));
+        _queued++;
+    }
+    {
+        // Take _mu so a worker between its check and wait() cannot miss the wakeup
+        lock_guard<mutex> lk(_mu);
+    }
+    _workCv.notify_one();
+}
+
+void WorkStealingPool::wait() {
+    unique_lock<mutex> lk(_mu);
+    _doneCv.wait(lk, [this] { return _pending.load() == 0; });
+}
+
+bool WorkStealingPool::popLocal(int id, Task& t) {
+    Queue& q = *_queues[id];
+    lock_guard<mutex> lk(q.mu);
+    if (q.tasks.empty()) return false;
+    t = std::move(q.tasks.back());
+    q.tasks.pop_back();
+    _queued--;
+    return true;
+}
+
+bool WorkStealingPool::steal(int id, Task& t) {
+    size_t n = _queues.size();
+    for (size_t k = 1; k < n; ++k) {
+        Queue& q = *_queues[(id + k) % n];
+        lock_guard<mutex> lk(q.mu);
+        if (q.tasks.empty()) continue;
+        t = std::move(q.tasks.front());
+        q.tasks.pop_front();
+        _queued--;
+        _steals++;
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::run(int id) {
+    tlsPool = this;
+    tlsWorker = id;
+
+    while (true) {
+        Task t;
+        if (popLocal(id, t) || steal(id, t)) {
+            t();
+            if (--_pending == 0) {
+                lock_guard<mutex> lk(_mu);
+                _doneCv.notify_all();
+            }
+            continue;
+        }
+
+        unique_lock<mutex> lk(_mu);
+        _workCv.wait(lk, [this] { return _quit || _queued.load() > 0; });
+        if (_quit && _queued.load() == 0) return;
+    }
+}
+
+// ---- MemoryBudget -----------------------------------------------------------
+
+void MemoryBudget::acquire(size_t n) {
+    unique_lock<mutex> lk(_mu);
+    _cv.wait(lk, [this, n] { return _used == 0 || _used + n <= _cap; });
+    _used += n;
+    if (_used > _peak) _peak = _used;
+}
+
+void MemoryBudget::release(size_t n) {
+    {
+        lock_guard<mutex> lk(_mu);
+        _used -= n;
+    }
+    _cv.notify_all();
+}
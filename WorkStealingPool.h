@@ -0,0 +1,79 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <vector>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <cstddef>
+
+// Fixed-size thread pool. Each worker owns a deque: it pushes and pops
+// at the back (newest first, cache friendly), idle workers steal from the
+// front of other deques (oldest, usually the biggest pieces of work).
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    explicit WorkStealingPool(int threads);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // From a worker: goes to that worker's deque. Otherwise round-robin.
+    void submit(Task t);
+
+    // Block until every submitted task (and the tasks they spawned) finished
+    void wait();
+
+    int size() const { return (int)_workers.size(); }
+    uint64_t steals() const { return _steals.load(); }
+
+private:
+    struct Queue {
+        std::mutex       mu;
+        std::deque<Task> tasks;
+    };
+
+    void run(int id);
+    bool popLocal(int id, Task& t);
+    bool steal(int id, Task& t);
+
+    std::vector<std::unique_ptr<Queue>> _queues;
+    std::vector<std::thread>            _workers;
+
+    std::mutex              _mu;          // guards sleeping / waiting
+    std::condition_variable _workCv;
+    std::condition_variable _doneCv;
+    std::atomic<size_t>     _pending{0};  // submitted, not yet finished
+    std::atomic<size_t>     _queued{0};   // sitting in a deque
+    std::atomic<unsigned>   _rr{0};
+    std::atomic<uint64_t>   _steals{0};
+    bool                    _quit = false;
+};
+
+// Blocking byte budget shared by concurrent tasks. A request larger than
+// the whole budget is still granted when nothing else is held.
+class MemoryBudget {
+public:
+    explicit MemoryBudget(size_t bytes) : _cap(bytes) {}
+
+    void acquire(size_t n);
+    void release(size_t n);
+
+    size_t peak() const { return _peak; }
+    size_t capacity() const { return _cap; }
+
+private:
+    std::mutex              _mu;
+    std::condition_variable _cv;
+    size_t                  _cap;
+    size_t                  _used = 0;
+    size_t                  _peak = 0;
+};
+
+#endif // WORK_STEALING_POOL_H
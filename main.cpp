@@ -6,46 +6,421 @@
 #include <functional>
 #include <iomanip>
 #include <set>
+#include <cstring>
+#include <cstdlib>
+#include <climits>
+#include <csignal>
+#include <chrono>
+#include <cstdio>
+#include <cerrno>
 
 #include "TseBaseParser.h"
 #include "TseFmt01Parser.h"
 #include "TseFmt06Parser.h"
 #include "Utils.h"
 #include "StreamFramer.h"
+#include "AsyncWriter.h"
+#include "InputSource.h"
+#include "BookLog.h"
+#include "BatchDriver.h"
+#include "BarAggregator.h"
+#include "ShmBus.h"
+#include "Arena.h"
+#include "FollowSource.h"
+#include "Checkpoint.h"
+#include "RefJoin.h"
+#include "BookDiff.h"
 
 using namespace std;
 
+// Print write-path metrics for one output sink
+static void printSinkMetrics(const AsyncSink& s) {
+    const AsyncSinkMetrics& m = s.metrics();
+    cout << "[METRICS] " << s.path()
+         << " bytes=" << m.bytesWritten
+         << " buffers=" << m.buffersSubmitted
+         << " stalls=" << m.bufferStalls
+         << " stallMs=" << fixed << setprecision(3) << m.stallNs / 1e6
+         << " flushMs=" << m.flushNs / 1e6
+         << " fsyncMs=" << m.fsyncNs / 1e6
+         << (m.ioError ? " IO_ERROR" : "")
+         << defaultfloat << "\n";
+}
+
+// Numeric option value argv[i] of option argv[i - 1]: digits only, in
+// [minValue, INT_MAX]. Prints the error and returns false otherwise.
+static bool parseCount(char* argv[], int i, long long minValue, long long& out) {
+    char* end = nullptr;
+    errno = 0;
+    out = strtoll(argv[i], &end, 10);
+    if (errno != 0 || end == argv[i] || *end != '\0' || out < minValue || out > INT_MAX) {
+        cerr << "[ERROR] " << argv[i - 1] << " needs a whole number from " << minValue
+             << " to " << INT_MAX << ": " << argv[i] << "\n";
+        return false;
+    }
+    return true;
+}
+
+// --follow: Ctrl-C / SIGTERM end the session cleanly
+static FollowSource* g_follower = nullptr;
+static void onStopSignal(int) {
+    if (g_follower) g_follower->stop();
+}
+
 
 // ====================================================================
 // main: Reads Tse.bin, writes to out_fmt01.csv and out_fmt06.csv (UTF-8)
+// Options:
+//   --odirect            open outputs with O_DIRECT (Linux)
+//   --io-buffers N       output buffers per file (default 2)
+//   --io-buffer-kb N     size of each output buffer in KB (default 4096)
+//   --decode-threads N   parallel zstd frame decoding (default 1)
+//   --booklog PATH       also write Format 06 updates as a delta-encoded book log
+//   --keyframe N         updates between book log keyframes (default 65536)
+//   --bars LIST          build OHLCV/VWAP bars, e.g. 1s,1m,5m -> out_bars.csv
+//   --bars-symbols N     symbols tracked for bars (default 65536)
+//   --shm NAME           publish decoded records to shared memory (see ShmBus.h);
+//                        the name is removed at exit, attached readers keep it
+//   --shm-slots N        shared-memory ring size (default 65536)
+//   --arena-kb N         per-batch arena chunk size in KB (default 1024)
+//   --hugepages          back arena chunks with huge pages when available
+//   --follow             keep reading a capture that is still being appended
+//                        (no row limit; stops on Ctrl-C, see FollowSource.h)
+//   --idle-exit N        with --follow, stop after N seconds without new data
+//   --enrich             append Format 01 name / reference / limits / change to
+//                        each Format 06 row (see RefJoin.h)
+//   --enrich-defer N     Format 06 rows held waiting for their Format 01 (default 65536)
+//   --diff               write only changed levels / trades of each Format 06 row
+//                        to out_fmt06_diff.csv instead of out_fmt06.csv
+//                        (see BookDiff.h, tools/diff_verify.cpp)
+//   --diff-snapshot N    messages between full book snapshots (default 1000000)
+//   --checkpoint-mb N    checkpoint every N MB of input (default 0: off)
+//   --checkpoint-file P  checkpoint path (default tse.ckpt, removed on success)
+//   --resume             continue from the checkpoint (same input and options;
+//                        see Checkpoint.h)
+// Batch mode (one output pair per input, all rows: no 100000-row limit;
+// see BatchDriver.h):
+//   --batch DIR|GLOB     process every matching capture concurrently
+//                        (DIR: its .bin / .gz / .zst files)
+//   --threads N          worker threads (default 0: all cores)
+//   --mem-mb N           memory budget for tasks in flight (default 512)
+//   --split-mb N         split raw captures larger than this (default 256, 0: never)
+//   --out-dir DIR        output directory (default .)
+// Input may be a raw capture or a .gz / .zst archive (detected by magic).
 // ====================================================================
 int main(int argc, char* argv[]) {
-    const char* inPath  = (argc > 1 ? argv[1] : "Tse.bin");
+    const char* inPath  = "Tse.bin";
+    AsyncWriterOptions ioOpt;
+    int decodeThreads = 1;
+    const char* bookLogPath = nullptr;
+    uint32_t keyframeEvery = 65536;
+    vector<int64_t> barIntervals;
+    size_t barSymbols = 65536;
+    const char* shmName = nullptr;
+    uint32_t shmSlots = 65536;
+    ArenaOptions arenaOpt;
+    bool follow = false;
+    FollowOptions followOpt;
+    bool diff = false;
+    uint32_t diffSnapshot = 1000000;
+    bool enrich = false;
+    size_t enrichDefer = 65536;
+    uint64_t checkpointBytes = 0;
+    const char* checkpointPath = "tse.ckpt";
+    bool resume = false;
+    const char* batchSpec = nullptr;
+    BatchOptions batchOpt;
+    bool ioSizeSet = false;
+    long long num = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--odirect") == 0) {
+            ioOpt.directIO = true;
+        } else if (strcmp(argv[i], "--io-buffers") == 0 && i + 1 < argc) {
+            if (!parseCount(argv, ++i, 1, num)) return 1;
+            ioOpt.bufferCount = (int)num;
+        } else if (strcmp(argv[i], "--io-buffer-kb") == 0 && i + 1 < argc) {
+            if (!parseCount(argv, ++i, 1, num)) return 1;
+            ioOpt.bufferSize = (size_t)num * 1024;
+            ioSizeSet = true;
+        } else if (strcmp(argv[i], "--decode-threads") == 0 && i + 1 < argc) {
+            if (!parseCount(argv, ++i, 1, num)) return 1;
+            decodeThreads = (int)num;
+        } else if (strcmp(argv[i], "--booklog") == 0 && i + 1 < argc) {
+            bookLogPath = argv[++i];
+        } else if (strcmp(argv[i], "--keyframe") == 0 && i + 1 < argc) {
+            if (!parseCount(argv, ++i, 1, num)) return 1;
+            keyframeEvery = (uint32_t)num;
+        } else if (strcmp(argv[i], "--bars") == 0 && i + 1 < argc) {
+            string list = argv[++i];
+            size_t b = 0;
+            while (b <= list.size()) {
+                size_t e = list.find(',', b);
+                if (e == string::npos) e = list.size();
+                int64_t us = BarAggregator::parseInterval(list.substr(b, e - b));
+                if (us <= 0) {
+                    cerr << "[ERROR] bad bar interval: " << list.substr(b, e - b) << "\n";
+                    return 1;
+                }
+                barIntervals.push_back(us);
+                b = e + 1;
+            }
+        } else if (strcmp(argv[i], "--bars-symbols") == 0 && i + 1 < argc) {
+            if (!parseCount(argv, ++i, 1, num)) return 1;
+            barSymbols = (size_t)num;
+        } else if (strcmp(argv[i], "--shm") == 0 && i + 1 < argc) {
+            shmName = argv[++i];
+        } else if (strcmp(argv[i], "--shm-slots") == 0 && i + 1 < argc) {
+            if (!parseCount(argv, ++i, 1, num)) return 1;
+            shmSlots = (uint32_t)num;
+        } else if (strcmp(argv[i], "--arena-kb") == 0 && i + 1 < argc) {
+            if (!parseCount(argv, ++i, 1, num)) return 1;
+            arenaOpt.chunkSize = (size_t)num * 1024;
+        } else if (strcmp(argv[i], "--hugepages") == 0) {
+            arenaOpt.hugePages = true;
+        } else if (strcmp(argv[i], "--follow") == 0) {
+            follow = true;
+        } else if (strcmp(argv[i], "--idle-exit") == 0 && i + 1 < argc) {
+            if (!parseCount(argv, ++i, 0, num)) return 1;
+            followOpt.idleExitSec = (int)num;
+        } else if (strcmp(argv[i], "--diff") == 0) {
+            diff = true;
+        } else if (strcmp(argv[i], "--diff-snapshot") == 0 && i + 1 < argc) {
+            if (!parseCount(argv, ++i, 1, num)) return 1;
+            diffSnapshot = (uint32_t)num;
+        } else if (strcmp(argv[i], "--enrich") == 0) {
+            enrich = true;
+        } else if (strcmp(argv[i], "--enrich-defer") == 0 && i + 1 < argc) {
+            if (!parseCount(argv, ++i, 1, num)) return 1;
+            enrichDefer = (size_t)num;
+        } else if (strcmp(argv[i], "--checkpoint-mb") == 0 && i + 1 < argc) {
+            if (!parseCount(argv, ++i, 0, num)) return 1;
+            checkpointBytes = (uint64_t)num * 1024 * 1024;
+        } else if (strcmp(argv[i], "--checkpoint-file") == 0 && i + 1 < argc) {
+            checkpointPath = argv[++i];
+        } else if (strcmp(argv[i], "--resume") == 0) {
+            resume = true;
+        } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batchSpec = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            if (!parseCount(argv, ++i, 0, num)) return 1;
+            batchOpt.threads = (int)num;
+        } else if (strcmp(argv[i], "--mem-mb") == 0 && i + 1 < argc) {
+            if (!parseCount(argv, ++i, 1, num)) return 1;
+            batchOpt.memoryBudget = (size_t)num * 1024 * 1024;
+        } else if (strcmp(argv[i], "--split-mb") == 0 && i + 1 < argc) {
+            if (!parseCount(argv, ++i, 0, num)) return 1;
+            batchOpt.splitBytes = (size_t)num * 1024 * 1024;
+        } else if (strcmp(argv[i], "--out-dir") == 0 && i + 1 < argc) {
+            batchOpt.outDir = argv[++i];
+        } else {
+            inPath = argv[i];
+        }
+    }
+
+    if (batchSpec) {
+        vector<string> inputs = expandInputs(batchSpec);
+        if (inputs.empty()) {
+            cerr << "[ERROR] no input matches " << batchSpec << "\n";
+            return 1;
+        }
+        // Many sinks are open at once: default to smaller buffers
+        if (!ioSizeSet) ioOpt.bufferSize = 1024 * 1024;
+        batchOpt.io = ioOpt;
+        batchOpt.decodeThreads = decodeThreads;
+        batchOpt.arena = arenaOpt;
+        return runBatch(inputs, batchOpt);
+    }
+
     const char* outPath01 = "out_fmt01.csv";
-    const char* outPath06 = "out_fmt06.csv";
+    if (diff && enrich) {
+        cerr << "[ERROR] --diff and --enrich cannot be combined.\n";
+        return 1;
+    }
+    const char* outPath06 = diff ? "out_fmt06_diff.csv" : "out_fmt06.csv";
     const size_t CHUNK  = 2048;     // Read 2 KB at a time
-    const int MAX_OUT   = 100000;  // Max output rows
+    const int MAX_OUT   = follow ? INT_MAX : 100000;  // Max output rows
 
     StreamFramer framer;
     int outCount01 = 0, outCount06 = 0;
     set<string> unsupportVersions;  // Track not supported versions
     
-    // Output files
-    ofstream fout01(outPath01, ios::binary);
-    ofstream fout06(outPath06, ios::binary);
+    // --resume: outputs are cut back to the checkpoint and appended to
+    Checkpoint ckpt;
+    if (resume) {
+        if (!ckpt.load(checkpointPath)) {
+            cerr << "[ERROR] " << checkpointPath << " is not a readable checkpoint.\n";
+            return 1;
+        }
+        if (ckpt.input != inPath) {
+            cerr << "[ERROR] checkpoint is for " << ckpt.input << ", not " << inPath << "\n";
+            return 1;
+        }
+    }
+
+    // Output files: both share one submission ring
+    WriteRing ring;
+    ring.start();
+    auto openOutput = [&](const char* path) -> unique_ptr<AsyncSink> {
+        if (!resume) return ring.openSink(path, ioOpt);
+        bool found = false;
+        uint64_t size = ckpt.outputSize(path, found);
+        if (!found) {
+            cerr << "[ERROR] checkpoint has no state for " << path << " (options changed?)\n";
+            return nullptr;
+        }
+        return ring.resumeSink(path, ioOpt, size);
+    };
+    unique_ptr<AsyncSink> fout01 = openOutput(outPath01);
+    unique_ptr<AsyncSink> fout06 = openOutput(outPath06);
     if (!fout01) { cerr << "[ERROR] " << outPath01 << " cannot create.\n"; return 1; }
     if (!fout06) { cerr << "[ERROR] " << outPath06 << " cannot create.\n"; return 1; }
 
+    // Optional binary book log (same ring)
+    unique_ptr<AsyncSink> foutLog;
+    unique_ptr<BookLogWriter> bookLog;
+    if (bookLogPath) {
+        foutLog = openOutput(bookLogPath);
+        if (!foutLog) { cerr << "[ERROR] " << bookLogPath << " cannot create.\n"; return 1; }
+        bookLog.reset(new BookLogWriter(foutLog.get(), keyframeEvery, resume));
+    }
+
+    // Optional bar aggregation (same ring)
+    const char* outPathBars = "out_bars.csv";
+    unique_ptr<AsyncSink> foutBars;
+    unique_ptr<CsvBarSink> barSink;
+    unique_ptr<BarAggregator> bars;
+    if (!barIntervals.empty()) {
+        foutBars = openOutput(outPathBars);
+        if (!foutBars) { cerr << "[ERROR] " << outPathBars << " cannot create.\n"; return 1; }
+        barSink.reset(new CsvBarSink(foutBars.get(), resume));
+        bars.reset(new BarAggregator(barIntervals, barSink.get(), barSymbols));
+    }
+
+    // Optional change-only Format 06 output (replaces the full rows)
+    unique_ptr<BookDiffWriter> bookDiff;
+    if (diff) bookDiff.reset(new BookDiffWriter(fout06.get(), diffSnapshot, resume));
+
+    // Optional Format 01 join on the Format 06 rows
+    unique_ptr<RefJoin> refJoin;
+    if (enrich) refJoin.reset(new RefJoin(fout06.get(), enrichDefer));
+
+    // Optional shared-memory publisher for local consumers (created below,
+    // after the last early return, so the name is always unlinked)
+    unique_ptr<ShmPublisher> shm;
+
+    // Per-batch arena: string temporaries and CSV lines of one input chunk,
+    // released after the chunk is framed
+    Arena batchArena(arenaOpt);
+    // Records are reused across messages so their strings keep capacity
+    Tse01Record rec01;
+    Tse06Record rec06;
+
     // Register parsers
     unordered_map<string, unique_ptr<TseBaseParser>> parsers;
     bool header01Wrote = false;
     bool header06Wrote = false;
-    // Open input file
-    ifstream fin(inPath, ios::binary);
+    // Open input file (raw / gzip / zstd, or a growing raw capture)
+    unique_ptr<InputSource> fin;
+    FollowSource* follower = nullptr;
+    if (follow) {
+        unique_ptr<FollowSource> fs = FollowSource::open(inPath, followOpt);
+        follower = fs.get();
+        fin = std::move(fs);
+    } else {
+        fin = InputSource::open(inPath, decodeThreads);
+    }
     if (!fin) {
         cerr << "Cannot open input file: " << inPath << "\n";
         return 1;
     }    
+    if (resume) {
+        // Engine state, row counters, framer bytes, then the input position
+        bool ok = true;
+        if (const string* st = ckpt.section("main")) {
+            StateReader r(*st);
+            r.get(outCount01);
+            r.get(outCount06);
+            r.get(header01Wrote);
+            r.get(header06Wrote);
+            ok = r.done();
+        } else {
+            ok = false;
+        }
+        const string* diffState = ckpt.section("diff");
+        if (ok && bookDiff) {
+            ok = diffState != nullptr;
+            if (ok) {
+                StateReader r(*diffState);
+                ok = bookDiff->loadState(r) && r.done();
+            }
+        }
+        const string* joinState = ckpt.section("refjoin");
+        if (ok && refJoin) {
+            ok = joinState != nullptr;
+            if (ok) {
+                StateReader r(*joinState);
+                ok = refJoin->loadState(r) && r.done();
+            }
+        }
+        const string* barState = ckpt.section("bars");
+        if (ok && bars) {
+            ok = barState != nullptr;
+            if (ok) {
+                StateReader r(*barState);
+                ok = barSink->loadState(r) && bars->loadState(r) && r.done();
+            }
+        }
+        const string* logState = ckpt.section("booklog");
+        if (ok && bookLog) {
+            ok = logState != nullptr;
+            if (ok) {
+                StateReader r(*logState);
+                ok = bookLog->loadState(r) && r.done();
+            }
+        }
+        if (!ok) {
+            cerr << "[ERROR] " << checkpointPath << " does not match these options.\n";
+            return 1;
+        }
+        // --follow: the stream offset spans rotations, resume inside the file
+        const string* followState = ckpt.section("follow");
+        if ((followState != nullptr) != (follower != nullptr)) {
+            cerr << "[ERROR] " << checkpointPath << " does not match these options.\n";
+            return 1;
+        }
+        if (follower) {
+            FollowSource::Position pos;
+            StateReader r(*followState);
+            r.get(pos);
+            if (!r.done() || !follower->resumeAt(pos, ckpt.inputOffset)) {
+                cerr << "[ERROR] " << inPath << " was rotated or truncated since the checkpoint.\n";
+                return 1;
+            }
+        } else if (!fin->skip(ckpt.inputOffset)) {
+            cerr << "[ERROR] " << inPath << " is shorter than the checkpoint offset.\n";
+            return 1;
+        }
+        framer.restore(ckpt.framerOffset, (const uint8_t*)ckpt.framerBytes.data(),
+                       ckpt.framerBytes.size());
+        cout << "Resumed at input offset " << ckpt.inputOffset
+             << " (" << outCount01 << " / " << outCount06 << " rows)\n";
+    }
+    if (shmName) {
+        shm.reset(new ShmPublisher());
+        if (!shm->create(shmName, shmSlots)) return 1;
+    }
+    if (follower) {
+        // Caught up with the writer: push buffered rows out to the files
+        follower->onIdle = [&] {
+            fout01->flush();
+            fout06->flush();
+            if (foutBars) foutBars->flush();
+            if (foutLog) foutLog->flush();
+        };
+        g_follower = follower;
+        signal(SIGINT, onStopSignal);
+        signal(SIGTERM, onStopSignal);
+    }
 
     // Callback for processing each message
     auto onMessage = [&](const vector<uint8_t>& msg, const string& version) {
@@ -69,6 +444,7 @@ int main(int argc, char* argv[]) {
                 cout << "[Error] version: " << version << " parser create fail." << "\n";
                 return;
             }
+            parser->setArena(&batchArena);
             it = parsers.emplace(version, std::move(parser)).first;
         }
 
@@ -76,13 +452,18 @@ int main(int argc, char* argv[]) {
         if( version == "01") {
             if (outCount01 >= MAX_OUT) return;
             
-            Tse01Record rec01;
+            rec01.checksumOK = true;
             if (it->second->parseOneMSG01(msg.data(), (int)msg.size(), &rec01)) {
                 if( !header01Wrote ) {
-                    fout01 << it->second->csvHeader() << "\n";
+                    fout01->write(it->second->csvHeader());
+                    fout01->put('\n');
                     header01Wrote = true;
                 } 
-                fout01 << it->second->recToCsv01(&rec01) << "\n";
+                string_view line = it->second->recToCsv01(&rec01, batchArena);
+                fout01->write(line.data(), line.size());
+                fout01->put('\n');
+                if (refJoin) refJoin->onRef(rec01);
+                if (shm) shm->publish(rec01);
                 outCount01++;
                 
                 // Progress output every 100000 records
@@ -107,13 +488,28 @@ int main(int argc, char* argv[]) {
         else if( version == "06") {
             if (outCount06 >= MAX_OUT) return;
             
-            Tse06Record rec06;
+            rec06.checksumOK = true;
             if (it->second->parseOneMSG06(msg.data(), (int)msg.size(), &rec06)) {
-                if( !header06Wrote ) {
-                    fout06 << it->second->csvHeader() << "\n";
+                if( !header06Wrote && !bookDiff ) {
+                    fout06->write(refJoin ? RefJoin::header(it->second->csvHeader())
+                                          : it->second->csvHeader());
+                    fout06->put('\n');
                     header06Wrote = true;
                 } 
-                fout06 << it->second->recToCsv06(&rec06) << "\n";
+                if (bookDiff) {
+                    bookDiff->append(rec06);
+                } else {
+                    string_view line = it->second->recToCsv06(&rec06, batchArena);
+                    if (refJoin) {
+                        refJoin->onQuote(rec06, line);
+                    } else {
+                        fout06->write(line.data(), line.size());
+                        fout06->put('\n');
+                    }
+                }
+                if (bookLog) bookLog->append(rec06);
+                if (bars) bars->onMessage(rec06);
+                if (shm) shm->publish(rec06);
                 outCount06++;
                 
                 // Progress output every 100000 records
@@ -137,28 +533,204 @@ int main(int argc, char* argv[]) {
         }
     };
 
+    // Checkpoint between two feeds: outputs are synced so the recorded
+    // sizes are on disk before the file that names them
+    uint64_t lastCheckpoint = fin->metrics().outputBytes;
+    uint64_t checkpoints = 0, checkpointNs = 0, checkpointFileBytes = 0;
+    auto takeCheckpoint = [&]() {
+        uint64_t t0 = chrono::duration_cast<chrono::nanoseconds>(
+            chrono::steady_clock::now().time_since_epoch()).count();
+        Checkpoint c;
+        c.input = inPath;
+        c.inputOffset = fin->metrics().outputBytes;
+        c.framerOffset = framer.messageOffset();
+        c.framerBytes.assign(framer.pending().begin(), framer.pending().end());
+        c.outputs.emplace_back(outPath01, fout01->sync());
+        c.outputs.emplace_back(outPath06, fout06->sync());
+        if (foutBars) c.outputs.emplace_back(outPathBars, foutBars->sync());
+        if (foutLog) c.outputs.emplace_back(bookLogPath, foutLog->sync());
+
+        string st;
+        StateWriter w(st);
+        w.put(outCount01);
+        w.put(outCount06);
+        w.put(header01Wrote);
+        w.put(header06Wrote);
+        c.setSection("main", std::move(st));
+        if (bookDiff) {
+            string ds;
+            StateWriter dw(ds);
+            bookDiff->saveState(dw);
+            c.setSection("diff", std::move(ds));
+        }
+        if (refJoin) {
+            string js;
+            StateWriter jw(js);
+            refJoin->saveState(jw);
+            c.setSection("refjoin", std::move(js));
+        }
+        if (bars) {
+            string bs;
+            StateWriter bw(bs);
+            barSink->saveState(bw);
+            bars->saveState(bw);
+            c.setSection("bars", std::move(bs));
+        }
+        if (bookLog) {
+            string ls;
+            StateWriter lw(ls);
+            bookLog->saveState(lw);
+            c.setSection("booklog", std::move(ls));
+        }
+        if (follower) {
+            string fs;
+            StateWriter fw(fs);
+            fw.put(follower->position());
+            c.setSection("follow", std::move(fs));
+        }
+        size_t n = c.save(checkpointPath);
+        if (n) {
+            checkpoints++;
+            checkpointFileBytes += n;
+        }
+        checkpointNs += chrono::duration_cast<chrono::nanoseconds>(
+            chrono::steady_clock::now().time_since_epoch()).count() - t0;
+    };
+
     vector<uint8_t> chunk(CHUNK);
+    uint64_t generation = follower ? follower->generation() : 0;
 
     // Main loop: read chunk, feed to framer
     while (outCount01 < MAX_OUT || outCount06 < MAX_OUT) {
-        fin.read((char*)chunk.data(), CHUNK);
-        streamsize got = fin.gcount();
+        long got = fin->read(chunk.data(), CHUNK);
 
-        if (got <= 0) break;
+        if (got < 0) {
+            cerr << "[ERROR] read failed: " << inPath << "\n";
+            break;
+        }
+        if (got == 0) break;
+
+        // Rotated / truncated: a held partial message belongs to the old file
+        if (follower && follower->generation() != generation) {
+            generation = follower->generation();
+            framer.reset();
+        }
 
         framer.feed(chunk.data(), (size_t)got, onMessage);
+        batchArena.reset();
+
+        if (checkpointBytes && fin->metrics().outputBytes - lastCheckpoint >= checkpointBytes) {
+            lastCheckpoint = fin->metrics().outputBytes;
+            takeCheckpoint();
+        }
 
-        // If we read less than CHUNK, we reached EOF
-        if (got < (streamsize)CHUNK)
+        // If we read less than CHUNK, we reached EOF (a followed file just has no more yet)
+        if (!follower && got < (long)CHUNK) {
+            cerr << "Warning: Incomplete record at EOF ignored.\n";
             break;
+        }
     }
 
-    if (!fin && fin.eof()) {
-        cerr << "Warning: Incomplete record at EOF ignored.\n";
+    // Drain, fsync and close outputs before stopping the ring
+    if (refJoin) refJoin->flush();
+    bool ioOK = fout01->close();
+    ioOK = fout06->close() && ioOK;
+    if (bars) {
+        bars->flush();
+        ioOK = foutBars->close() && ioOK;
     }
+    if (bookLog) {
+        bookLog->finish();
+        ioOK = foutLog->close() && ioOK;
+    }
+    ring.stop();
+    // Finished cleanly: a later --resume must not replay into complete outputs
+    if (ioOK && (checkpointBytes || resume)) remove(checkpointPath);
 
     cout << "Done.\n";
     cout << "Output " << outCount01 << " rows to " << outPath01 << "\n";
     cout << "Output " << outCount06 << " rows to " << outPath06 << "\n";
-    return 0;
+    const InputMetrics& im = fin->metrics();
+    double outMB = im.outputBytes / (1024.0 * 1024.0);
+    cout << "[METRICS] input codec=" << im.codec
+         << " compressed=" << im.compressedBytes
+         << " decompressed=" << im.outputBytes
+         << " frames=" << im.frames
+         << " decodeMs=" << fixed << setprecision(3) << im.decodeNs / 1e6
+         << " msPerMB=" << (outMB > 0 ? im.decodeNs / 1e6 / outMB : 0.0)
+         << defaultfloat << "\n";
+    if (follower) {
+        const FollowMetrics& fm = follower->followMetrics();
+        cout << "[METRICS] follow waiter=" << fm.waiter
+             << " wakeups=" << fm.wakeups
+             << " events=" << fm.notifyEvents
+             << " rotations=" << fm.rotations
+             << " truncations=" << fm.truncations
+             << " maxWaitMs=" << fixed << setprecision(3) << fm.maxWaitUs / 1e3
+             << defaultfloat << "\n";
+        g_follower = nullptr;
+    }
+    cout << "[METRICS] writer backend=" << ring.backendName()
+         << (ioOpt.directIO ? " O_DIRECT" : "") << "\n";
+    printSinkMetrics(*fout01);
+    printSinkMetrics(*fout06);
+    if (checkpointBytes) {
+        cout << "[METRICS] checkpoint count=" << checkpoints
+             << " totalMs=" << fixed << setprecision(3) << checkpointNs / 1e6
+             << " avgMs=" << (checkpoints ? checkpointNs / 1e6 / checkpoints : 0.0)
+             << " fileBytes=" << (checkpoints ? checkpointFileBytes / checkpoints : 0)
+             << defaultfloat << "\n";
+    }
+    const ArenaStats& as = batchArena.stats();
+    cout << "[METRICS] arena allocs=" << as.allocs
+         << " bytes=" << as.bytes
+         << " batches=" << as.resets
+         << " peakBatchKB=" << fixed << setprecision(1) << as.peakBatch / 1024.0
+         << " chunks=" << as.chunks
+         << " reservedKB=" << as.reserved / 1024.0
+         << " hugeChunks=" << as.hugeChunks
+         << defaultfloat << "\n";
+    if (bars) {
+        cout << "Output " << barSink->rows() << " bars to " << outPathBars
+             << " (trades=" << bars->tradesUsed()
+             << " deferredSkipped=" << bars->deferredSkipped()
+             << " duplicates=" << bars->duplicates()
+             << " symbolOverflow=" << bars->symbolOverflow()
+             << " late=" << bars->lateTrades() << ")\n";
+        if (bars->symbolOverflow()) {
+            cerr << "[WARN] " << bars->symbolOverflow() << " trades got no bars: more than "
+                 << barSymbols << " symbols, raise --bars-symbols\n";
+        }
+    }
+    if (bookDiff) {
+        cout << "[METRICS] diff messages=" << bookDiff->messages()
+             << " events=" << bookDiff->events()
+             << " snapshots=" << bookDiff->snapshots()
+             << " bytesPerMessage=" << fixed << setprecision(2)
+             << (bookDiff->messages() ? (double)fout06->metrics().bytesWritten / bookDiff->messages() : 0.0)
+             << defaultfloat << "\n";
+    }
+    if (refJoin) {
+        cout << "[METRICS] enrich joined=" << refJoin->joined()
+             << " deferred=" << refJoin->deferred()
+             << " released=" << refJoin->released()
+             << " expired=" << refJoin->expired()
+             << " maxHeld=" << refJoin->maxHeld()
+             << " symbolOverflow=" << refJoin->symbolOverflow() << "\n";
+    }
+    if (shm) {
+        cout << "[METRICS] shm " << shmName << " published=" << shm->published()
+             << " snapshotOverflow=" << shm->snapshotOverflow() << "\n";
+        shm->unlink();
+    }
+    if (bookLog) {
+        printSinkMetrics(*foutLog);
+        cout << "[METRICS] booklog updates=" << bookLog->updates()
+             << " keyframes=" << bookLog->keyframes()
+             << " bytesPerUpdate=" << fixed << setprecision(2)
+             << (bookLog->updates() ? (double)bookLog->bytes() / bookLog->updates() : 0.0)
+             << " vsCsv=" << (bookLog->bytes() ? (double)fout06->metrics().bytesWritten / bookLog->bytes() : 0.0)
+             << "x" << defaultfloat << "\n";
+    }
+    return ioOK ? 0 : 1;
 }
@@ -0,0 +1,91 @@
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+
+#include "../BookDiff.h"
+#include "../TseFmt06Parser.h"
+
+using namespace std;
+
+// ====================================================================
+// diff_verify: rebuild full Format 06 rows from `main --diff` output
+//   diff_verify DIFF FULL           compare every rebuilt row with FULL
+//                                   (out_fmt06.csv of a run without --diff)
+//   diff_verify DIFF --csv OUT      write the rebuilt rows to OUT
+// Snapshots inside DIFF are checked against the books rebuilt so far.
+// Exit status 0 only if every row and snapshot matches.
+// ====================================================================
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        cerr << "usage: diff_verify DIFF FULL | diff_verify DIFF --csv OUT\n";
+        return 1;
+    }
+    const char* fullPath = nullptr;
+    const char* csvPath = nullptr;
+    if (strcmp(argv[2], "--csv") == 0 && argc > 3) csvPath = argv[3];
+    else fullPath = argv[2];
+
+    BookDiffReader reader;
+    if (!reader.open(argv[1])) {
+        cerr << "[ERROR] " << argv[1] << " is not a diff stream.\n";
+        return 1;
+    }
+
+    ifstream ffull;
+    ofstream fcsv;
+    string expect;
+    if (fullPath) {
+        ffull.open(fullPath, ios::binary);
+        if (!ffull || !getline(ffull, expect)) { cerr << "[ERROR] " << fullPath << " cannot open.\n"; return 1; }
+    } else {
+        fcsv.open(csvPath, ios::binary);
+        if (!fcsv) { cerr << "[ERROR] " << csvPath << " cannot create.\n"; return 1; }
+    }
+
+    TseFmt06Parser fmt;
+    Tse06Record rec;
+    if (fcsv.is_open()) fcsv << fmt.csvHeader() << "\n";
+
+    auto t0 = chrono::steady_clock::now();
+    uint64_t rows = 0, mismatches = 0;
+    while (reader.next(rec)) {
+        string row = fmt.recToCsv06(&rec);
+        rows++;
+        if (fcsv.is_open()) {
+            fcsv << row << "\n";
+            continue;
+        }
+        if (!getline(ffull, expect)) {
+            cerr << "[MISMATCH] row " << rows << ": " << fullPath << " has fewer rows\n";
+            mismatches++;
+            break;
+        }
+        if (row != expect) {
+            if (mismatches < 5) {
+                cerr << "[MISMATCH] row " << rows << " (diff line " << reader.lineNo() << ")\n"
+                     << "  rebuilt: " << row << "\n"
+                     << "  full:    " << expect << "\n";
+            }
+            mismatches++;
+        }
+    }
+    double sec = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    if (fullPath && mismatches == 0 && getline(ffull, expect)) {
+        cerr << "[MISMATCH] " << fullPath << " has more rows than the diff stream\n";
+        mismatches++;
+    }
+    if (reader.corrupt()) {
+        cerr << "[ERROR] malformed line " << reader.lineNo() << " in " << argv[1] << "\n";
+    }
+
+    cout << "rows=" << rows
+         << " mismatches=" << mismatches
+         << " snapshots=" << reader.snapshots()
+         << " snapshotMismatch=" << reader.snapshotMismatch()
+         << " sec=" << sec
+         << " Mrows/s=" << (sec > 0 ? rows / sec / 1e6 : 0.0) << "\n";
+    return (mismatches || reader.snapshotMismatch() || reader.corrupt()) ? 1 : 0;
+}
@@ -0,0 +1,223 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+
+#include "../StreamFramer.h"
+#include "../TseFmt01Parser.h"
+#include "../TseFmt06Parser.h"
+#include "../TseSchema.h"
+#include "../Utils.h"
+
+using namespace std;
+
+// ====================================================================
+// schema_bench: compare TseSchema.h decoders with hand-written decoding
+//   schema_bench CAPTURE [--rounds N]
+//
+// For every Format 01 / 06 message in the capture:
+//   hand     hand-coded offsets with the string helpers (the decoding the
+//            parsers used before TseSchema.h)
+//   schema   parseOneMSG01 / parseOneMSG06 (generated from the field tables)
+//   hand-int hand-coded offsets with integer BCD (Format 06 fixed part)
+//   proj     schema projection of the same fields (Decoder<> subset)
+// Results of each pair are compared field by field before timing.
+// ====================================================================
+
+// ---- hand-written decoders ----------------------------------------------------
+
+static bool hand01(const uint8_t* msg, int len, Tse01Record& r) {
+    if (len < 114 || msg[0] != 0x1B) return false;
+    r.esc = msg[0];
+    try { r.msgLen = stoi(bcdToDigitString(&msg[1], 2)); } catch (...) { r.msgLen = 0; }
+    r.bizType = bcdToDigitString(&msg[3], 1);
+    r.fmtCode = bcdToDigitString(&msg[4], 1);
+    r.fmtVer  = bcdToDigitString(&msg[5], 1);
+    r.seq     = bcdToDigitString(&msg[6], 4);
+    r.stockId   = asciiField(&msg[10], 6);
+    r.stockName = big5ToUtf8(reinterpret_cast<const char*>(&msg[16]), 16);
+    r.industry  = asciiField(&msg[32], 2);
+    r.secType   = asciiField(&msg[34], 2);
+    r.tradeNote = asciiField(&msg[36], 2);
+    try { r.abnCode = stoi(bcdToDigitString(&msg[38], 1)); } catch (...) { r.abnCode = 0; }
+    r.board = asciiField(&msg[39], 1);
+    if (!parsePrice_fromBCD5(&msg[40], r.refPrice)) return false;
+    if (!parsePrice_fromBCD5(&msg[45], r.upPrice))  return false;
+    if (!parsePrice_fromBCD5(&msg[50], r.dnPrice))  return false;
+    try { r.matchCycleSec = stoi(bcdToDigitString(&msg[61], 3)); } catch (...) { r.matchCycleSec = 0; }
+    r.lineNote = bcdToDigitString(&msg[110], 1);
+    r.checksum = msg[111];
+    return true;
+}
+
+static bool hand06(const uint8_t* msg, int len, Tse06Record& r) {
+    if (len < 32 || msg[0] != 0x1B) return false;
+    r.seq     = bcdToDigitString(&msg[6], 4);
+    r.stockId = asciiField(&msg[10], 6);
+    parseMatchTime_fromBCD6(&msg[16], r.matchTime);
+    r.itemBitmap  = msg[22];
+    r.limitBitmap = msg[23];
+    if (!parseQty_fromBCD4(&msg[25], r.cumQty)) return false;
+    r.bidPx.fill(0.0); r.bidQty.fill(0);
+    r.askPx.fill(0.0); r.askQty.fill(0);
+    r.lastPx = 0.0; r.lastQty = 0;
+    int pos = 29, end = len - 3;
+    if (tse06HasTrade(r.itemBitmap) && pos + 9 <= end) {
+        parsePrice_fromBCD5(&msg[pos], r.lastPx);
+        uint32_t q = 0;
+        if (parseQty_fromBCD4(&msg[pos + 5], q)) r.lastQty = tse06IsDeferred(r.limitBitmap) ? 0 : q;
+        pos += 9;
+    }
+    if ((r.itemBitmap & 1) || tse06IsDeferred(r.limitBitmap)) return true;
+    int nb = min((r.itemBitmap >> 4) & 7, 5), na = min((r.itemBitmap >> 1) & 7, 5);
+    for (int i = 0; i < nb && pos + 9 <= end; ++i, pos += 9) {
+        parsePrice_fromBCD5(&msg[pos], r.bidPx[i]);
+        parseQty_fromBCD4(&msg[pos + 5], r.bidQty[i]);
+    }
+    for (int i = 0; i < na && pos + 9 <= end; ++i, pos += 9) {
+        parsePrice_fromBCD5(&msg[pos], r.askPx[i]);
+        parseQty_fromBCD4(&msg[pos + 5], r.askQty[i]);
+    }
+    return true;
+}
+
+// Fixed part of Format 06 with integer BCD, the fastest hand-written form
+struct Fixed06 {
+    string   stockId;
+    uint32_t cumQty = 0;
+    uint8_t  itemBitmap = 0, limitBitmap = 0;
+};
+
+static bool handInt06(const uint8_t* msg, Fixed06& f) {
+    f.stockId = asciiField(&msg[10], 6);
+    f.itemBitmap  = msg[22];
+    f.limitBitmap = msg[23];
+    uint32_t v = 0;
+    for (int i = 25; i < 29; ++i) {
+        uint8_t hi = msg[i] >> 4, lo = msg[i] & 0xF;
+        if (hi > 9 || lo > 9) return parseQty_fromBCD4(&msg[25], f.cumQty);
+        v = v * 100 + hi * 10 + lo;
+    }
+    f.cumQty = v;
+    return true;
+}
+
+using Proj06 = tse::Decoder<
+    tse::Bind<tse::Fmt06::StockId,     &Fixed06::stockId>,
+    tse::Bind<tse::Fmt06::ItemBitmap,  &Fixed06::itemBitmap>,
+    tse::Bind<tse::Fmt06::LimitBitmap, &Fixed06::limitBitmap>,
+    tse::Bind<tse::Fmt06::CumQty,      &Fixed06::cumQty>>;
+
+// ---- comparison -----------------------------------------------------------------
+
+static bool same01(const Tse01Record& a, const Tse01Record& b) {
+    return a.msgLen == b.msgLen && a.seq == b.seq && a.stockId == b.stockId &&
+           a.stockName == b.stockName && a.industry == b.industry && a.abnCode == b.abnCode &&
+           a.refPrice == b.refPrice && a.upPrice == b.upPrice && a.dnPrice == b.dnPrice &&
+           a.matchCycleSec == b.matchCycleSec && a.lineNote == b.lineNote && a.checksum == b.checksum;
+}
+
+static bool same06(const Tse06Record& a, const Tse06Record& b) {
+    return a.seq == b.seq && a.stockId == b.stockId && a.matchTime == b.matchTime &&
+           a.cumQty == b.cumQty && a.lastPx == b.lastPx && a.lastQty == b.lastQty &&
+           a.bidPx == b.bidPx && a.bidQty == b.bidQty && a.askPx == b.askPx && a.askQty == b.askQty;
+}
+
+template <class Fn>
+static double timeRounds(int rounds, Fn fn) {
+    auto t0 = chrono::steady_clock::now();
+    for (int k = 0; k < rounds; ++k) fn();
+    return chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        cerr << "usage: schema_bench CAPTURE [--rounds N]\n";
+        return 1;
+    }
+    int rounds = 5;
+    for (int i = 2; i < argc; ++i) {
+        if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) rounds = max(1, atoi(argv[++i]));
+    }
+
+    // Frame once; the timed loops see only decode work
+    vector<vector<uint8_t>> msgs01, msgs06;
+    {
+        ifstream fin(argv[1], ios::binary);
+        if (!fin) { cerr << "Cannot open input file: " << argv[1] << "\n"; return 1; }
+        StreamFramer framer;
+        vector<uint8_t> chunk(64 * 1024);
+        auto onMessage = [&](const vector<uint8_t>& msg, const string& fmt) {
+            if (fmt == "01") msgs01.push_back(msg);
+            else if (fmt == "06") msgs06.push_back(msg);
+        };
+        while (fin) {
+            fin.read((char*)chunk.data(), (streamsize)chunk.size());
+            if (fin.gcount() <= 0) break;
+            framer.feed(chunk.data(), (size_t)fin.gcount(), onMessage);
+        }
+    }
+
+    TseFmt01Parser p01;
+    TseFmt06Parser p06;
+
+    // Equivalence first
+    uint64_t mismatch = 0;
+    for (const auto& m : msgs01) {
+        Tse01Record a, b;
+        bool okA = hand01(m.data(), (int)m.size(), a);
+        bool okB = p01.parseOneMSG01(m.data(), (int)m.size(), &b);
+        if (okA != okB || (okA && !same01(a, b))) mismatch++;
+    }
+    for (const auto& m : msgs06) {
+        Tse06Record a, b;
+        Fixed06 fa, fb;
+        bool okA = hand06(m.data(), (int)m.size(), a);
+        bool okB = p06.parseOneMSG06(m.data(), (int)m.size(), &b);
+        if (okA != okB || (okA && !same06(a, b))) mismatch++;
+        bool okC = handInt06(m.data(), fa);
+        bool okD = Proj06::decode(m.data(), fb);
+        if (okC != okD || fa.stockId != fb.stockId || fa.cumQty != fb.cumQty ||
+            fa.itemBitmap != fb.itemBitmap || fa.limitBitmap != fb.limitBitmap) mismatch++;
+    }
+    cout << "fmt01=" << msgs01.size() << " fmt06=" << msgs06.size() << " mismatch=" << mismatch << "\n";
+    if (mismatch) return 1;
+
+    // Timing; the checksum keeps the optimizer from dropping the work
+    uint64_t check = 0;
+    auto report = [&](const char* name, size_t n, double sec) {
+        double per = n ? sec * 1e9 / ((double)n * rounds) : 0.0;
+        cout << left << setw(16) << name << " nsPerMsg=" << fixed << setprecision(1) << per << "\n";
+    };
+
+    Tse01Record r01;
+    report("01 hand", msgs01.size(), timeRounds(rounds, [&] {
+        for (const auto& m : msgs01) check += hand01(m.data(), (int)m.size(), r01) ? r01.abnCode : 0;
+    }));
+    report("01 schema", msgs01.size(), timeRounds(rounds, [&] {
+        for (const auto& m : msgs01) check += p01.parseOneMSG01(m.data(), (int)m.size(), &r01) ? r01.abnCode : 0;
+    }));
+
+    Tse06Record r06;
+    report("06 hand", msgs06.size(), timeRounds(rounds, [&] {
+        for (const auto& m : msgs06) check += hand06(m.data(), (int)m.size(), r06) ? r06.cumQty : 0;
+    }));
+    report("06 schema", msgs06.size(), timeRounds(rounds, [&] {
+        for (const auto& m : msgs06) check += p06.parseOneMSG06(m.data(), (int)m.size(), &r06) ? r06.cumQty : 0;
+    }));
+
+    Fixed06 f;
+    report("06 fixed hand", msgs06.size(), timeRounds(rounds, [&] {
+        for (const auto& m : msgs06) check += handInt06(m.data(), f) ? f.cumQty : 0;
+    }));
+    report("06 fixed proj", msgs06.size(), timeRounds(rounds, [&] {
+        for (const auto& m : msgs06) check += Proj06::decode(m.data(), f) ? f.cumQty : 0;
+    }));
+
+    cout << "check=" << check << "\n";
+    return 0;
+}
@@ -0,0 +1,166 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <cstring>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "../ShmBus.h"
+#include "../StreamFramer.h"
+#include "../TseFmt01Parser.h"
+#include "../TseFmt06Parser.h"
+
+using namespace std;
+
+// ====================================================================
+// shm_harness: publish a capture to shared memory and consume it from
+// several local reader processes (POSIX fork).
+//   shm_harness CAPTURE [--readers N] [--slots N] [--rate MSG_PER_SEC]
+//
+// Each reader checks that ring indexes arrive in order with no gaps other
+// than reported overruns, verifies the final snapshot of every symbol
+// against the last record it received, and prints publish-to-read
+// latency percentiles.
+// ====================================================================
+
+static const char* SHM_NAME = "tse_shm_harness";
+
+static int runReader(int id, uint64_t total) {
+    ShmReader reader;
+    for (int tries = 0; !reader.open(SHM_NAME, true); ++tries) {
+        if (tries > 1000) { cerr << "[reader " << id << "] cannot open\n"; return 2; }
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+
+    vector<uint32_t> lat;
+    lat.reserve((size_t)total);
+    vector<pair<string, BookState>> lastBook;
+    ShmMessage m;
+    uint64_t expect = 0, bad = 0;
+    auto idleSince = chrono::steady_clock::now();
+
+    while (reader.position() < total) {
+        ShmReader::Status st = reader.poll(m);
+        if (st == ShmReader::NONE) {
+            if (chrono::steady_clock::now() - idleSince > chrono::seconds(5)) break;
+            continue;
+        }
+        idleSince = chrono::steady_clock::now();
+        if (st == ShmReader::OVERRUN) { expect = reader.position(); continue; }
+
+        uint64_t now = shmNowNs();
+        if (m.index != expect) bad++;
+        expect = m.index + 1;
+        lat.push_back((uint32_t)min<uint64_t>(now - m.publishNs, 0xFFFFFFFFu));
+
+        if (m.type == SHM_FMT06) {
+            string id(m.q06.stockId);
+            auto it = find_if(lastBook.begin(), lastBook.end(),
+                              [&id](const pair<string, BookState>& p) { return p.first == id; });
+            if (it == lastBook.end()) lastBook.emplace_back(id, m.q06.book);
+            else it->second = m.q06.book;
+        }
+    }
+
+    // Snapshot table must hold the last update of every symbol we saw
+    // (only meaningful if this reader was never lapped)
+    uint64_t snapBad = 0;
+    for (const auto& p : lastBook) {
+        if (reader.lost()) break;
+        ShmQuote06 q;
+        if (!reader.snapshot(p.first, q) || memcmp(&q.book, &p.second, sizeof(BookState)) != 0) snapBad++;
+    }
+
+    sort(lat.begin(), lat.end());
+    auto pct = [&lat](double p) -> uint32_t {
+        return lat.empty() ? 0 : lat[min(lat.size() - 1, (size_t)(p * lat.size()))];
+    };
+    cout << "[reader " << id << "] got=" << lat.size() << " lost=" << reader.lost()
+         << " orderErrors=" << bad << " snapshotMismatch=" << snapBad
+         << " latNs p50=" << pct(0.50) << " p99=" << pct(0.99)
+         << " p99.9=" << pct(0.999) << " max=" << (lat.empty() ? 0 : lat.back()) << endl; // _exit skips flush
+    return (bad || snapBad) ? 1 : 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        cerr << "usage: shm_harness CAPTURE [--readers N] [--slots N] [--rate MSG_PER_SEC]\n";
+        return 1;
+    }
+    int readers = 3;
+    uint32_t slots = 65536;
+    double rate = 0;
+    for (int i = 2; i < argc; ++i) {
+        if (strcmp(argv[i], "--readers") == 0 && i + 1 < argc) readers = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--slots") == 0 && i + 1 < argc) slots = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) rate = atof(argv[++i]);
+    }
+
+    // Decode first so the publish loop measures only the shared-memory path
+    vector<Tse01Record> recs01;
+    vector<Tse06Record> recs06;
+    vector<char> order;   // '1' / '6'
+    {
+        ifstream fin(argv[1], ios::binary);
+        if (!fin) { cerr << "Cannot open input file: " << argv[1] << "\n"; return 1; }
+        TseFmt01Parser p01;
+        TseFmt06Parser p06;
+        StreamFramer framer;
+        vector<uint8_t> chunk(64 * 1024);
+        auto onMessage = [&](const vector<uint8_t>& msg, const string& fmt) {
+            if (fmt == "01") {
+                Tse01Record r;
+                if (p01.parseOneMSG01(msg.data(), (int)msg.size(), &r)) { recs01.push_back(r); order.push_back('1'); }
+            } else if (fmt == "06") {
+                Tse06Record r;
+                if (p06.parseOneMSG06(msg.data(), (int)msg.size(), &r)) { recs06.push_back(r); order.push_back('6'); }
+            }
+        };
+        while (fin) {
+            fin.read((char*)chunk.data(), (streamsize)chunk.size());
+            if (fin.gcount() <= 0) break;
+            framer.feed(chunk.data(), (size_t)fin.gcount(), onMessage);
+        }
+    }
+
+    ShmPublisher pub;
+    if (!pub.create(SHM_NAME, slots)) return 1;
+
+    vector<pid_t> kids;
+    for (int i = 0; i < readers; ++i) {
+        pid_t pid = fork();
+        if (pid == 0) _exit(runReader(i, order.size()));
+        kids.push_back(pid);
+    }
+    this_thread::sleep_for(chrono::milliseconds(200)); // let readers attach
+
+    auto t0 = chrono::steady_clock::now();
+    size_t i01 = 0, i06 = 0;
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (rate > 0) {
+            auto due = t0 + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(i / rate));
+            while (chrono::steady_clock::now() < due) {}
+        }
+        if (order[i] == '1') pub.publish(recs01[i01++]);
+        else                 pub.publish(recs06[i06++]);
+    }
+    double sec = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    cout << "[publisher] records=" << order.size() << " sec=" << sec
+         << " nsPerPublish=" << (order.empty() ? 0.0 : sec * 1e9 / order.size()) << "\n";
+
+    int failed = 0;
+    for (pid_t pid : kids) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) failed++;
+    }
+    pub.unlink();
+    cout << (failed ? "FAILED" : "OK") << " readers=" << readers << " failed=" << failed << "\n";
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,76 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <cstring>
+#include <cstdlib>
+
+#include "../ShmBus.h"
+
+using namespace std;
+
+// ====================================================================
+// shm_reader: consume records published by `main --shm NAME`
+//   shm_reader NAME                   follow live, print stats every second
+//   shm_reader NAME --from-start      replay what is still in the ring
+//   shm_reader NAME --symbol 2330     print the latest book of one symbol
+// ====================================================================
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        cerr << "usage: shm_reader NAME [--from-start] [--symbol ID]\n";
+        return 1;
+    }
+    bool fromStart = false;
+    const char* symbol = nullptr;
+    for (int i = 2; i < argc; ++i) {
+        if (strcmp(argv[i], "--from-start") == 0) fromStart = true;
+        else if (strcmp(argv[i], "--symbol") == 0 && i + 1 < argc) symbol = argv[++i];
+    }
+
+    ShmReader reader;
+    if (!reader.open(argv[1], fromStart)) {
+        cerr << "[ERROR] shared memory " << argv[1] << " not found or incompatible.\n";
+        return 1;
+    }
+
+    if (symbol) {
+        ShmQuote06 q;
+        if (!reader.snapshot(symbol, q)) {
+            cout << symbol << " not in snapshot table\n";
+            return 1;
+        }
+        cout << fixed << setprecision(4) << q.stockId
+             << " time=" << usToMatchTime(q.book.timeUs)
+             << " last=" << ticksToPx(q.book.lastPx) << "x" << q.book.lastQty << "\n";
+        for (int i = 0; i < 5; ++i) {
+            cout << "  bid" << i + 1 << " " << ticksToPx(q.book.bidPx[i]) << "x" << q.book.bidQty[i]
+                 << "  ask" << i + 1 << " " << ticksToPx(q.book.askPx[i]) << "x" << q.book.askQty[i] << "\n";
+        }
+        return 0;
+    }
+
+    ShmMessage m;
+    uint64_t n01 = 0, n06 = 0, latSum = 0, latMax = 0, n = 0;
+    auto last = chrono::steady_clock::now();
+    while (true) {
+        ShmReader::Status st = reader.poll(m);
+        if (st == ShmReader::OK) {
+            uint64_t lat = shmNowNs() - m.publishNs;
+            latSum += lat;
+            if (lat > latMax) latMax = lat;
+            n++;
+            if (m.type == SHM_FMT01) n01++;
+            else n06++;
+        } else if (st == ShmReader::NONE) {
+            this_thread::yield();
+        }
+
+        auto now = chrono::steady_clock::now();
+        if (now - last >= chrono::seconds(1)) {
+            cout << "fmt01=" << n01 << " fmt06=" << n06 << " lost=" << reader.lost()
+                 << " avgLatNs=" << (n ? latSum / n : 0) << " maxLatNs=" << latMax << "\n";
+            latSum = latMax = n = 0;
+            last = now;
+        }
+    }
+}